@@ -0,0 +1,25 @@
+/**
+ * File: bench.h
+ * @author agent
+ *
+ * Function declarations for the bench.c file.
+ *
+ * bench.c times the functions that run every second or on every
+ * button repeat. It only exists in builds with INTERVALS_BENCH.
+ *
+ */
+#ifndef BENCH_H
+#define BENCH_H
+#include "../includes/config.h"
+
+#ifdef INTERVALS_BENCH
+
+void runBenchmarks();
+
+#else
+
+#define runBenchmarks()
+
+#endif
+
+#endif
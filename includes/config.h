@@ -0,0 +1,101 @@
+/**
+ * File: config.h
+ * @author agent
+ *
+ * Compile time switches for the app.
+ *
+ * Everything in here is decided when the app is built. Nothing
+ * in this file costs anything at runtime.
+ *
+ */
+#ifndef _CONFIG_H
+#define _CONFIG_H
+
+/**
+ * Build profiles. The profile is picked from the platform being built
+ * for. aplite (and SDK 2, which only builds for aplite) gets the small
+ * profile: fewer intervals and no event traces, to keep the heap and the
+ * binary small. The platforms with more RAM get the full profile.
+ */
+#if defined(PBL_PLATFORM_BASALT) || defined(PBL_PLATFORM_CHALK) \
+		|| defined(PBL_PLATFORM_DIORITE) || defined(PBL_PLATFORM_EMERY)
+#define PROFILE_FULL
+#else
+#define PROFILE_SMALL
+#endif
+
+/**
+ * MAX_INTERVALS is the most intervals a session can have. The interval
+ * title only has room for two digits, so this can't go past 99.
+ *
+ * RUN_PROGRESS_BAR draws a bar under the countdown showing how far
+ * through the interval the run is.
+ *
+ * TRACE_KEY_COUNT is how many persist keys an event trace may use,
+ * 64 events each.
+ *
+ * VIBE_FIVES changes how the end of an interval is signalled. Without it
+ * interval N gets N short pulses. With it a long pulse stands for five
+ * and short pulses for the rest (interval 12 is long, long, short,
+ * short), and the end of the last interval gets a quick buzz of its own.
+ * That keeps the motor time down with a lot of intervals.
+ */
+#ifdef PROFILE_FULL
+#define MAX_INTERVALS 20
+#define RUN_PROGRESS_BAR
+#define TRACE_KEY_COUNT 8
+#define VIBE_FIVES
+#else
+#define MAX_INTERVALS 10
+#define TRACE_KEY_COUNT 4
+#endif
+
+/**
+ * The low power run display shows only the minutes left, rounded up and
+ * redrawn each time they go down, until LOW_POWER_THRESHOLD_SECS are left
+ * in the interval.
+ * Then it counts down every second as usual. Set LOW_POWER_DISPLAY to
+ * true to have it on.
+ */
+#define LOW_POWER_DISPLAY false
+#define LOW_POWER_THRESHOLD_SECS 60
+
+/**
+ * Once the battery is down to this many percent (and not charging) the
+ * app goes into economy mode: the units being set don't flash, the run
+ * display works as the low power display above and the vibrations are
+ * shorter. The watch reports the charge in steps of 10.
+ */
+#define ECONOMY_BATTERY_PERCENT 20
+
+/**
+ * Uncomment to build the debug instrumentation into the app.
+ * Release builds should always leave this commented out.
+ */
+//#define INTERVALS_DEBUG
+
+/**
+ * Debug builds only. Uncomment to record every button press, tick and
+ * timer callback into a trace that is saved when the app closes.
+ */
+//#define INTERVALS_TRACE
+
+/**
+ * Debug builds only. Uncomment to replay the saved trace when the app
+ * starts instead of taking input from the buttons.
+ */
+//#define INTERVALS_TRACE_REPLAY
+
+//The small profile has no room for event traces.
+#ifdef PROFILE_SMALL
+#undef INTERVALS_TRACE
+#undef INTERVALS_TRACE_REPLAY
+#endif
+
+/**
+ * Uncomment to run the hot path benchmarks when the app starts.
+ * Leave INTERVALS_DEBUG off so the render statistics don't skew them.
+ */
+//#define INTERVALS_BENCH
+
+#endif
@@ -0,0 +1,46 @@
+/**
+ * File: hud.h
+ * @author agent
+ *
+ * Function declarations for the hud.c file.
+ *
+ * hud.c is a debug overlay with live power counters. Tapping the
+ * watch shows or hides it. It only exists in debug builds.
+ * In release builds the calls compile away to nothing.
+ *
+ */
+#ifndef HUD_H
+#define HUD_H
+#include "../includes/config.h"
+
+/**
+ * The things the HUD counts.
+ */
+typedef enum
+{
+	HUD_WAKEUP,
+	HUD_FLASH_TIMER,
+	HUD_VIBE_TIMER,
+	HUD_TEXT_DRAW,
+	HUD_COUNTER_COUNT
+} HudCounter;
+
+#ifdef INTERVALS_DEBUG
+
+void hudCount(HudCounter counter);
+void hudDeinit();
+void hudInit(Layer *parent);
+void hudTickEnd();
+void hudTickStart();
+
+#else
+
+#define hudCount(counter)
+#define hudDeinit()
+#define hudInit(parent)
+#define hudTickEnd()
+#define hudTickStart()
+
+#endif
+
+#endif
@@ -12,7 +12,6 @@
 #define INTERVAL_SET_SCREEN_H
 
 void adjustIntervals(int8_t change);
-void deinitIntervalSetScreen();
 void initIntervalSetScreen();
 void setIntervalCountTxt(uint16_t count);
 
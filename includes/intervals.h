@@ -13,9 +13,12 @@
 #include "../includes/types.h"
 
 
+void button_held_down(ClickRecognizerRef recognizer);
+void button_held_up(ClickRecognizerRef recognizer);
 void button_pressed_down(ClickRecognizerRef recognizer);
 void button_pressed_up(ClickRecognizerRef recognizer);
-void click_provider(Window *window);
+void button_released(ClickRecognizerRef recognizer);
+void count_click_provider(Window *window);
 void formatTime(uint16_t time, char *timeStr, bool setHours);
 SettingsState getCurrState();
 uint16_t * getIntervals();
@@ -23,16 +26,20 @@ uint8_t getIntervalCount();
 uint8_t getCurrIntervalSetIdx();
 char * getTimeTitleStr();
 void handle_deinit();
+void handle_focus(bool in_focus);
 void handle_init();
 void handle_second_tick(struct tm *tick_time, TimeUnits units_changed);
-void handle_timer_event();
 int main();
 void nextState();
 void prevState();
+void run_click_provider(Window *window);
 void runApp();
 void select_double_press(ClickRecognizerRef rec);
 void select_long_press(ClickRecognizerRef rec);
 void select_pressed(ClickRecognizerRef rec);
+void setClickConfig();
 void setIntervalCount(uint8_t ct);
+void time_set_click_provider(Window *window);
+void updateTickService();
 
 #endif
@@ -0,0 +1,69 @@
+/**
+ * File: layout.h
+ * @author agent
+ *
+ * Function declarations for the layout.c file.
+ *
+ * layout.c draws the text for the screens. Each screen is a single
+ * layer that draws all of its text from a list of TextLayouts, built
+ * from a const table of TextLayoutDescs. The big mm:ss digits come
+ * from a bitmap atlas instead of a font.
+ *
+ */
+#ifndef LAYOUT_H
+#define LAYOUT_H
+
+/*
+ The screen size the layout tables are built for. The screens were laid
+ out for 144x168. Bigger displays get the full width and the same
+ layout moved down to the middle.
+ */
+#if defined(PBL_PLATFORM_EMERY)
+#define SCREEN_WIDTH 200
+#define SCREEN_HEIGHT 228
+#elif defined(PBL_ROUND)
+#define SCREEN_WIDTH 180
+#define SCREEN_HEIGHT 180
+#else
+#define SCREEN_WIDTH 144
+#define SCREEN_HEIGHT 168
+#endif
+#define LAYOUT_TOP ((SCREEN_HEIGHT - 168) / 2)
+
+//A frame in a layout table, moved down for the display.
+#define LAYOUT_FRAME(x, y, w, h) { { (x), (y) + LAYOUT_TOP }, { (w), (h) } }
+
+/**
+ * How one piece of text on a screen is described in its layout table.
+ * The tables are const so they stay in flash.
+ */
+typedef struct
+{
+	GRect frame;
+	//A system font key, or NULL to draw from the digit atlas.
+	const char *fontKey;
+	GTextAlignment alignment;
+	//Fixed text, or the buffer the screen keeps the text in.
+	const char *text;
+} TextLayoutDesc;
+
+/**
+ * Where and how one piece of text on a screen is drawn.
+ */
+typedef struct
+{
+	GRect frame;
+	//NULL for text drawn from the digit atlas.
+	GFont font;
+	GTextAlignment alignment;
+	const char *text;
+} TextLayout;
+
+void buildLayout(const TextLayoutDesc *desc, TextLayout *layout,
+		uint8_t count);
+void deinitDigitAtlas();
+void drawLayout(GContext *ctx, const TextLayout *layout);
+void drawLayouts(GContext *ctx, const TextLayout *layout, uint8_t count);
+void initDigitAtlas();
+
+#endif
@@ -0,0 +1,33 @@
+/**
+ * File: perfStats.h
+ * @author agent
+ *
+ * Function declarations for the perfStats.c file.
+ *
+ * perfStats.c measures how much of the screen each update redraws.
+ * It only exists in debug builds. In release builds the calls
+ * compile away to nothing.
+ *
+ */
+#ifndef PERF_STATS_H
+#define PERF_STATS_H
+#include "../includes/config.h"
+#include "../includes/layout.h"
+
+#ifdef INTERVALS_DEBUG
+
+void perfStatsEndFrame(const char *source);
+void perfStatsRedraw(Layer *layer);
+void perfStatsShown(const TextLayout *layout, bool shown);
+void perfStatsText(const TextLayout *layout, const char *text);
+
+#else
+
+#define perfStatsEndFrame(source)
+#define perfStatsRedraw(layer)
+#define perfStatsShown(layout, shown)
+#define perfStatsText(layout, text)
+
+#endif
+
+#endif
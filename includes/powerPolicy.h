@@ -0,0 +1,31 @@
+/**
+ * File: powerPolicy.h
+ * @author agent
+ *
+ * Function declarations for the powerPolicy.c file.
+ *
+ * powerPolicy.c decides what the app may spend power on. It
+ * switches to an economy policy when the battery runs low.
+ *
+ */
+#ifndef POWER_POLICY_H
+#define POWER_POLICY_H
+
+/**
+ * What the app is allowed to spend power on.
+ */
+typedef struct
+{
+	//Blink the unit being set in TIME_SET.
+	bool flashUnits;
+	//Only show the minutes on the run screen while far from the end of an interval.
+	bool minuteDisplay;
+	//Use the shorter vibrations.
+	bool shortVibes;
+} PowerPolicy;
+
+const PowerPolicy * powerPolicy();
+void powerPolicyDeinit();
+void powerPolicyInit();
+
+#endif
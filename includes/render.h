@@ -0,0 +1,21 @@
+/**
+ * File: render.h
+ * @author agent
+ *
+ * Function declarations for the render.c file.
+ *
+ * render.c marks the screens dirty so Pebble redraws each one at most
+ * once per frame, however many changes land in it, and not at all
+ * while the app is out of focus.
+ *
+ */
+#ifndef RENDER_H
+#define RENDER_H
+#include "../includes/types.h"
+
+bool isRenderingSuspended();
+void markScreenDirty(DirtyScreen screen);
+void resumeRendering(DirtyScreen screen);
+void suspendRendering();
+
+#endif
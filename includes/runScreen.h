@@ -12,14 +12,20 @@
 #define INTERVAL_RUN_SCREEN_H
 
 void activateRunMode();
-void deinitRunScreen();
+void advanceRunPosition(uint8_t *interval, uint32_t *elapsedMs, uint32_t ms);
 void doVibrate();
+void endInterval();
+void getRunState(uint8_t *interval, uint32_t *elapsedMs, uint32_t *totalMs);
 void initRunScreen();
+bool isMinuteDisplay();
 bool isRunning();
+void resumeRunMode(uint8_t interval, uint32_t elapsedMs, uint32_t totalMs,
+		bool running, uint32_t closedMs);
 void skipToNextInterval();
 void skipToPrevInterval();
 void toggleRunning();
 void tick();
+void updateRunPowerPolicy();
 void updateRunTimeScreen();
 void vibrate();
 
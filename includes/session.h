@@ -0,0 +1,33 @@
+/**
+ * File: session.h
+ * @author agent
+ *
+ * Function declarations for the session.c file.
+ *
+ * session.c keeps a run in progress in persistent storage, as a
+ * snapshot and a log of what happened since, and picks it back
+ * up when the app opens again.
+ *
+ */
+#ifndef SESSION_H
+#define SESSION_H
+
+/**
+ * The things that happen to a run that go in the log.
+ */
+typedef enum
+{
+	SESSION_PAUSE = 1,
+	SESSION_RESUME,
+	SESSION_SKIP_NEXT,
+	SESSION_SKIP_PREV,
+	SESSION_BOUNDARY
+} SessionEvent;
+
+void clearSession();
+void logSessionEvent(SessionEvent event);
+bool restoreSession();
+void saveSession();
+void startSession();
+
+#endif
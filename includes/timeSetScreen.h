@@ -14,8 +14,11 @@
 
 void adjustIntervalSetTime(int8_t change);
 void changeUnit();
-void deinitTimeSetScreen();
+void holdRepeat();
 void initTimeSetScreen();
+void startTimeSetHold(int8_t direction);
+void startUnitFlash();
+void stopTimeSetHold();
 void updateSetTimeScreen();
 void flashUnit();
 
@@ -0,0 +1,29 @@
+/**
+ * File: timerWheel.h
+ * @author agent
+ *
+ * Function declarations for the timerWheel.c file.
+ *
+ * timerWheel.c keeps the deadlines for everything in the app that
+ * runs off a timer and only ever has one AppTimer armed, for the
+ * nearest of them.
+ *
+ */
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+#include "../includes/types.h"
+
+typedef void (*TimerWheelHandler)();
+
+void timerWheelCancel(TimerSlot slot);
+void timerWheelDeinit();
+void timerWheelInit();
+bool timerWheelIsScheduled(TimerSlot slot);
+uint32_t timerWheelNow();
+void timerWheelSchedule(TimerSlot slot, uint32_t deadline,
+		TimerWheelHandler handler);
+void timerWheelScheduleIn(TimerSlot slot, uint32_t delay,
+		TimerWheelHandler handler);
+uint32_t timerWheelSecond();
+
+#endif
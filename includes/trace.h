@@ -0,0 +1,52 @@
+/**
+ * File: trace.h
+ * @author agent
+ *
+ * Function declarations for the trace.c file.
+ *
+ * trace.c records the input and timer events the app handles so
+ * a session can be replayed later. It only exists in debug builds
+ * with INTERVALS_TRACE or INTERVALS_TRACE_REPLAY turned on.
+ *
+ */
+#ifndef TRACE_H
+#define TRACE_H
+#include "../includes/config.h"
+
+/**
+ * The events that get recorded. One per handler.
+ */
+typedef enum
+{
+	TRACE_BUTTON_UP = 1,
+	TRACE_BUTTON_DOWN,
+	TRACE_SELECT,
+	TRACE_SELECT_DOUBLE,
+	TRACE_SELECT_LONG,
+	TRACE_TICK,
+	TRACE_TIMER,
+	TRACE_HOLD_UP,
+	TRACE_HOLD_DOWN,
+	TRACE_RELEASE
+} TraceEvent;
+
+#if defined(INTERVALS_DEBUG) && (defined(INTERVALS_TRACE) || defined(INTERVALS_TRACE_REPLAY))
+#define TRACE_ENABLED
+
+void traceDeinit();
+void traceInit();
+bool traceIsReplaying();
+void traceRecord(TraceEvent event);
+
+#define TRACE_EVENT(event) traceRecord(event)
+
+#else
+
+#define traceDeinit()
+#define traceInit()
+#define traceIsReplaying() false
+#define TRACE_EVENT(event)
+
+#endif
+
+#endif
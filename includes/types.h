@@ -23,4 +23,40 @@ typedef enum
 	SETTING_SECOND = 1, SETTING_MINUTE = 0
 } SettingsUnit;
 
+/**
+ * Everything that runs off a timer gets its own slot in the timer wheel.
+ * Each interval program needs one slot for its interval boundaries. There
+ * is only one program for now: the run state in runScreen.c is still a
+ * single run, so a second program needs that split up first.
+ */
+typedef enum
+{
+	TIMER_PROGRAM,
+	TIMER_VIBE,
+	TIMER_FLASH,
+	TIMER_HOLD_REPEAT,
+	TIMER_GRANULARITY,
+	TIMER_SESSION_LOG,
+	TIMER_SLOT_COUNT
+} TimerSlot;
+
+/**
+ * The screens, for marking one as needing to be redrawn.
+ */
+typedef enum
+{
+	DIRTY_INTERVAL_COUNT, DIRTY_SET_TIME, DIRTY_RUN
+} DirtyScreen;
+
+/**
+ * Keys for everything the app keeps in persistent storage.
+ * Each value can be at most PERSIST_DATA_MAX_LENGTH bytes.
+ */
+typedef enum
+{
+	PERSIST_SESSION_SNAPSHOT = 1,
+	PERSIST_SESSION_LOG = 2,
+	PERSIST_TRACE_COUNT = 100, PERSIST_TRACE_DATA = 101 //Through 100 + TRACE_KEY_COUNT
+} PersistKey;
+
 #endif
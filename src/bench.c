@@ -0,0 +1,141 @@
+/**
+ * File: bench.c
+ * @author agent <agent@local>
+ *
+ * Microbenchmarks for the per-second hot path.
+ *
+ * Each function that runs every second or on every button repeat is called
+ * in batches of BENCH_BATCH until at least BENCH_MIN_MS have gone by on
+ * time_ms(), so even a function that takes well under a microsecond is
+ * timed to better than 1%. The result is written to the app log as ns/op.
+ * This runs on the watch (or the emulator) right after the screens are
+ * built, before the user sees anything.
+ *
+ * The benchmarks run on a scratch run, with interval 1 set to 59:59. It is
+ * set up directly, not through the run mode buttons, so nothing is logged
+ * to the saved session. Everything is put back the way it was when they
+ * are done.
+ *
+ */
+#include <pebble.h>
+#include "../includes/types.h"
+#include "../includes/intervals.h"
+#include "../includes/intervalSetScreen.h"
+#include "../includes/timeSetScreen.h"
+#include "../includes/runScreen.h"
+#include "../includes/timerWheel.h"
+#include "../includes/bench.h"
+
+#ifdef INTERVALS_BENCH
+
+//How many calls are timed between looks at the clock.
+#define BENCH_BATCH 100
+//The shortest time each function is timed for.
+#define BENCH_MIN_MS 250
+
+//One benchmark. The function gets the iteration number.
+typedef struct
+{
+	const char *name;
+	void (*run)(uint16_t i);
+} Benchmark;
+
+static char benchTimeStr[9];
+
+static void benchFormatTime(uint16_t i)
+{
+	formatTime(i * 7, benchTimeStr, false);
+}
+
+static void benchFormatTimeHours(uint16_t i)
+{
+	formatTime(i * 7, benchTimeStr, true);
+}
+
+static void benchSetIntervalCountTxt(uint16_t i)
+{
+	setIntervalCountTxt(i % 10 + 1);
+}
+
+//tick() redraws the run screen itself, so this is the whole per-second cost.
+static void benchTick(uint16_t i)
+{
+	tick();
+}
+
+static void benchUpdateRunTimeScreen(uint16_t i)
+{
+	updateRunTimeScreen();
+}
+
+static void benchUpdateSetTimeScreen(uint16_t i)
+{
+	updateSetTimeScreen();
+}
+
+static const Benchmark benchmarks[] =
+{
+{ "formatTime", benchFormatTime },
+{ "formatTime (hours)", benchFormatTimeHours },
+{ "setIntervalCountTxt", benchSetIntervalCountTxt },
+{ "tick", benchTick },
+{ "updateRunTimeScreen", benchUpdateRunTimeScreen },
+{ "updateSetTimeScreen", benchUpdateSetTimeScreen } };
+
+/**
+ * Milliseconds on the watch clock.
+ */
+static uint32_t benchNow()
+{
+	time_t sec;
+	uint16_t ms;
+	time_ms(&sec, &ms);
+	return sec * 1000 + ms;
+}
+
+/**
+ * Run every benchmark and log the results.
+ */
+void runBenchmarks()
+{
+	uint16_t *intervals = getIntervals();
+	uint16_t savedTime = intervals[0];
+	uint32_t start, elapsed, ops, savedElapsedMs, savedTotalMs;
+	uint16_t i;
+	uint8_t b, savedInterval;
+	bool savedRunning = isRunning();
+
+	getRunState(&savedInterval, &savedElapsedMs, &savedTotalMs);
+	//A long interval keeps tick() away from the interval boundary.
+	intervals[0] = 3599;
+	resumeRunMode(0, 0, 0, true, 0);
+
+	for (b = 0; b < sizeof(benchmarks) / sizeof(benchmarks[0]); b++)
+	{
+		ops = 0;
+		start = benchNow();
+		do
+		{
+			for (i = 0; i < BENCH_BATCH; i++)
+			{
+				benchmarks[b].run(ops + i);
+			}
+			ops += BENCH_BATCH;
+			elapsed = benchNow() - start;
+		} while (elapsed < BENCH_MIN_MS);
+		APP_LOG(APP_LOG_LEVEL_INFO, "bench %s: %lu ns/op (%lu ops in %lu ms)",
+				benchmarks[b].name,
+				(unsigned long) ((uint64_t) elapsed * 1000000 / ops),
+				(unsigned long) ops, (unsigned long) elapsed);
+	}
+
+	//Put everything back.
+	timerWheelCancel(TIMER_PROGRAM);
+	timerWheelCancel(TIMER_GRANULARITY);
+	intervals[0] = savedTime;
+	resumeRunMode(savedInterval, savedElapsedMs, savedTotalMs, savedRunning, 0);
+	updateTickService();
+	setIntervalCountTxt(getIntervalCount());
+} //End runBenchmarks
+
+#endif
@@ -0,0 +1,184 @@
+/**
+ * File: hud.c
+ * @author agent <agent@local>
+ *
+ * A performance overlay for debug builds, for checking power behaviour on
+ * a real watch. Tapping the watch (a flick of the wrist) shows or hides it
+ * on any screen. It is on the accelerometer rather than the buttons because
+ * up and down do something on every screen. It shows:
+ *
+ *  - wakeups (timer wheel callbacks and ticks) in the last minute
+ *  - timers registered by flashUnit() and doVibrate() in the last minute
+ *  - text drawn by the screens in the last second
+ *  - heap in use
+ *  - how long the last handle_second_tick() took
+ *
+ * Everything lives in one static struct. Counting goes on whether or not
+ * the overlay is shown. The overlay is only redrawn when the app wakes up
+ * anyway so it doesn't add wakeups of its own.
+ *
+ */
+#include <pebble.h>
+#include <pebble_fonts.h>
+#include "../includes/layout.h"
+#include "../includes/timerWheel.h"
+#include "../includes/hud.h"
+
+#ifdef INTERVALS_DEBUG
+
+//The counters. Each one counts over a window and keeps the last full window.
+typedef struct
+{
+	uint16_t current[HUD_COUNTER_COUNT];
+	uint16_t last[HUD_COUNTER_COUNT];
+	uint32_t windowStart[HUD_COUNTER_COUNT];
+	time_t tickStartSec;
+	uint16_t tickStartMs;
+	uint16_t lastTickMs;
+	bool shown;
+} HudStats;
+
+static HudStats hud;
+static Layer *hudLayer = NULL;
+static char hudText[96];
+
+/**
+ * How long each counter's window is in ms. Text draws are per second,
+ * everything else per minute.
+ */
+static uint32_t windowLength(HudCounter counter)
+{
+	return (counter == HUD_TEXT_DRAW) ? 1000 : 60000;
+}
+
+/**
+ * Start a new window for a counter if its current one is over.
+ */
+static void rollWindow(HudCounter counter, uint32_t now)
+{
+	uint32_t length = windowLength(counter);
+	uint32_t elapsed = now - hud.windowStart[counter];
+
+	if (elapsed < length)
+	{
+		return;
+	}
+	//If a whole window went by with nothing counted, the last one was empty.
+	hud.last[counter] = (elapsed < length * 2) ? hud.current[counter] : 0;
+	hud.current[counter] = 0;
+	hud.windowStart[counter] = now - elapsed % length;
+}
+
+/**
+ * Draw the overlay. This is the update proc for hudLayer.
+ */
+static void drawHud(Layer *layer, GContext *ctx)
+{
+	uint32_t now = timerWheelNow();
+	uint8_t i;
+
+	for (i = 0; i < HUD_COUNTER_COUNT; i++)
+	{
+		rollWindow(i, now);
+	}
+	snprintf(hudText, sizeof(hudText),
+			"wakeups/min %d\nflash/min %d vibe/min %d\ntext/s %d\n"
+					"heap %d B\ntick %d ms", hud.last[HUD_WAKEUP],
+			hud.last[HUD_FLASH_TIMER], hud.last[HUD_VIBE_TIMER],
+			hud.last[HUD_TEXT_DRAW], (int) heap_bytes_used(), hud.lastTickMs);
+
+	graphics_context_set_fill_color(ctx, GColorBlack);
+	graphics_fill_rect(ctx, layer_get_bounds(layer), 0, GCornerNone);
+	graphics_context_set_text_color(ctx, GColorWhite);
+	graphics_draw_text(ctx, hudText, fonts_get_system_font(FONT_KEY_GOTHIC_14),
+			GRect(2, 0, SCREEN_WIDTH - 4, 80), GTextOverflowModeWordWrap,
+			GTextAlignmentLeft, NULL);
+} //End drawHud
+
+/**
+ * Redraw the overlay if it is up.
+ */
+static void refreshHud()
+{
+	if (hud.shown)
+	{
+		layer_mark_dirty(hudLayer);
+	}
+}
+
+/**
+ * Tap handler. A flick of the wrist toggles the overlay.
+ */
+static void hudTap(AccelAxisType axis, int32_t direction)
+{
+	hud.shown = !hud.shown;
+	layer_set_hidden(hudLayer, !hud.shown);
+	refreshHud();
+}
+
+/**
+ * Add one to a counter.
+ */
+void hudCount(HudCounter counter)
+{
+	rollWindow(counter, timerWheelNow());
+	hud.current[counter]++;
+	if (counter == HUD_WAKEUP)
+	{
+		refreshHud();
+	}
+}
+
+/**
+ * Clean up on app close.
+ */
+void hudDeinit()
+{
+	accel_tap_service_unsubscribe();
+	layer_destroy(hudLayer);
+	hudLayer = NULL;
+}
+
+/**
+ * Build the overlay on top of the screens. It starts hidden.
+ *
+ * @param parent - the window's root layer
+ */
+void hudInit(Layer *parent)
+{
+	uint32_t now = timerWheelNow();
+	uint8_t i;
+
+	for (i = 0; i < HUD_COUNTER_COUNT; i++)
+	{
+		hud.windowStart[i] = now;
+	}
+	hudLayer = layer_create(GRect(0, 0, SCREEN_WIDTH, 80));
+	layer_set_update_proc(hudLayer, drawHud);
+	layer_set_hidden(hudLayer, true);
+	layer_add_child(parent, hudLayer);
+	accel_tap_service_subscribe(hudTap);
+}
+
+/**
+ * handle_second_tick() is done. Work out how long it took.
+ */
+void hudTickEnd()
+{
+	time_t sec;
+	uint16_t ms;
+
+	time_ms(&sec, &ms);
+	hud.lastTickMs = (sec - hud.tickStartSec) * 1000 + ms - hud.tickStartMs;
+	refreshHud();
+}
+
+/**
+ * handle_second_tick() is starting.
+ */
+void hudTickStart()
+{
+	time_ms(&hud.tickStartSec, &hud.tickStartMs);
+}
+
+#endif
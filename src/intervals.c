@@ -12,11 +12,20 @@
  *
  */
 #include <pebble.h>
+#include "../includes/config.h"
 #include "../includes/types.h"
 #include "../includes/intervals.h"
+#include "../includes/bench.h"
+#include "../includes/hud.h"
 #include "../includes/intervalSetScreen.h"
+#include "../includes/powerPolicy.h"
+#include "../includes/render.h"
+#include "../includes/layout.h"
 #include "../includes/timeSetScreen.h"
 #include "../includes/runScreen.h"
+#include "../includes/session.h"
+#include "../includes/timerWheel.h"
+#include "../includes/trace.h"
 
 //The pointer for the app window
 static Window *window;
@@ -33,28 +42,45 @@ uint8_t intervalCount = 1;
 uint8_t currIntervalSetIdx = 0;
 
 //An array of 'seconds'. Each element corresponds to the time for one interval
-uint16_t intervals[10] =
+uint16_t intervals[MAX_INTERVALS] =
 { 0 };
 
 //Initial text for the set and run screens
 char setTimeTitleStr[] = "Interval 00";
 
+/**
+ * Down button raw press handler for the time set screens.
+ * Holding the button speeds up the changes.
+ */
+void button_held_down(ClickRecognizerRef recognizer)
+{
+	TRACE_EVENT(TRACE_HOLD_DOWN);
+
+	startTimeSetHold(-1);
+}
+
+/**
+ * Up button raw press handler for the time set screens.
+ */
+void button_held_up(ClickRecognizerRef recognizer)
+{
+	TRACE_EVENT(TRACE_HOLD_UP);
+
+	startTimeSetHold(1);
+}
+
 /**
  * Down button pressed handler.
  */
 void button_pressed_down(ClickRecognizerRef recognizer)
 {
+	TRACE_EVENT(TRACE_BUTTON_DOWN);
 
 	if (current_state == INTERVAL_COUNT)
 	{
 		//Decrease interval count.
 		adjustIntervals(-1);
 	}
-	else if (current_state == TIME_SET)
-	{
-		//Lower the currently selected 'set unit'
-		adjustIntervalSetTime(-1);
-	}
 	else //We're in run mode here and we'll go to the previous interval.
 	{
 		skipToPrevInterval();
@@ -66,16 +92,13 @@ void button_pressed_down(ClickRecognizerRef recognizer)
  */
 void button_pressed_up(ClickRecognizerRef recognizer)
 {
+	TRACE_EVENT(TRACE_BUTTON_UP);
+
 	if (current_state == INTERVAL_COUNT)
 	{
 		//Increase interval count.
 		adjustIntervals(1);
 	}
-	else if (current_state == TIME_SET)
-	{
-		//Increase the currently selected 'set unit'
-		adjustIntervalSetTime(1);
-	}
 	else //We're in run mode so skip to the next interval.
 	{
 		skipToNextInterval();
@@ -83,15 +106,21 @@ void button_pressed_up(ClickRecognizerRef recognizer)
 } //End button_pressed_up
 
 /**
- * Connect the buttons to the handler functions
+ * Up or down button released in the time set screens.
  */
-void click_provider(Window *window)
+void button_released(ClickRecognizerRef recognizer)
 {
+	TRACE_EVENT(TRACE_RELEASE);
 
-	window_single_click_subscribe(BUTTON_ID_SELECT,
-			(ClickHandler) select_pressed);
-	window_long_click_subscribe(BUTTON_ID_SELECT, 0,
-			(ClickHandler) select_long_press, NULL);
+	stopTimeSetHold();
+}
+
+/**
+ * Connect the buttons for the interval count screen.
+ * Select only needs the double press here.
+ */
+void count_click_provider(Window *window)
+{
 	window_multi_click_subscribe(BUTTON_ID_SELECT, 2, 2, 100, true,
 			(ClickHandler) select_double_press);
 
@@ -99,8 +128,7 @@ void click_provider(Window *window)
 			(ClickHandler) button_pressed_up);
 	window_single_repeating_click_subscribe(BUTTON_ID_DOWN, 200,
 			(ClickHandler) button_pressed_down);
-
-} //End settings_click_provider
+} //End count_click_provider
 
 /**
  * This function is used to format a time.
@@ -111,8 +139,6 @@ void click_provider(Window *window)
  */
 void formatTime(uint16_t time, char *timeStr, bool setHours)
 {
-	app_log(APP_LOG_LEVEL_INFO, "intervals", 101, "Passed in time %d", time);
-
 	uint16_t hours, mins, secs;
 
 	hours = time / 3600;
@@ -191,10 +217,23 @@ char * getTimeTitleStr()
  */
 void handle_deinit()
 {
-	//Destroy each sublayer
-	deinitIntervalSetScreen();
-	deinitTimeSetScreen();
-	deinitRunScreen();
+	//Save a run in progress so the next launch can pick it up
+	if (current_state == RUN_MODE)
+	{
+		saveSession();
+	}
+
+	//Free the digit atlas and the debug overlay
+	deinitDigitAtlas();
+	hudDeinit();
+
+	//Stop anything still waiting to fire
+	timerWheelDeinit();
+	powerPolicyDeinit();
+	app_focus_service_unsubscribe();
+
+	//Save the event trace in debug builds
+	traceDeinit();
 
 	layer_destroy(intervalLayer);
 	layer_destroy(setTimeLayer);
@@ -203,15 +242,57 @@ void handle_deinit()
 	window_destroy(window);
 }
 
+/**
+ * Called when a notification or another window covers the app, and
+ * again when it goes away. While covered nothing is drawn, the units
+ * don't flash and there are no ticks. The interval timers and their
+ * vibrations carry on as normal.
+ */
+void handle_focus(bool in_focus)
+{
+	if (in_focus)
+	{
+		//One redraw to catch up with whatever happened while covered.
+		if (current_state == INTERVAL_COUNT)
+		{
+			resumeRendering(DIRTY_INTERVAL_COUNT);
+		}
+		else if (current_state == TIME_SET)
+		{
+			resumeRendering(DIRTY_SET_TIME);
+			startUnitFlash();
+		}
+		else
+		{
+			resumeRendering(DIRTY_RUN);
+		}
+	}
+	else
+	{
+		suspendRendering();
+		timerWheelCancel(TIMER_FLASH);
+		//The release of a held button goes to whatever covers us.
+		stopTimeSetHold();
+	}
+	updateTickService();
+} //End handle_focus
+
 /**
  * Initializes the window and the three main "subroot" screen layers
  */
 void handle_init()
 {
+	//Start recording (or replaying) events in debug builds
+	traceInit();
+
+	//All the app's timers run off the timer wheel
+	timerWheelInit();
+
+	//Work out what we can spend power on before anything asks
+	powerPolicyInit();
+
 	//Create the window.
 	window = window_create();
-	window_set_click_config_provider(window,
-			(ClickConfigProvider) click_provider);
 
 	//Get the window layer and bounds.
 	Layer *windowLayer = window_get_root_layer(window);
@@ -222,55 +303,66 @@ void handle_init()
 	setTimeLayer = layer_create(windowBounds);
 	runLayer = layer_create(windowBounds);
 
+	//The big digits are drawn from a bitmap, load it once up front
+	initDigitAtlas();
+
 	//Initialize the three separate layers
 	initIntervalSetScreen();
 	initTimeSetScreen();
 	initRunScreen();
 
+	//Time the hot path functions in benchmark builds
+	runBenchmarks();
+
 	//Add the layers to the window layer.
 	layer_add_child(windowLayer, intervalLayer);
 	layer_add_child(windowLayer, setTimeLayer);
 	layer_add_child(windowLayer, runLayer);
 
+	//The debug overlay goes on top of all three
+	hudInit(windowLayer);
+
 	//Add the window to the stack
 	window_stack_push(window, true);
-	tick_timer_service_subscribe(SECOND_UNIT, handle_second_tick);
 
-	//RUN IT!
-	runApp();
+	//Go straight back into a saved run, or start from the beginning.
+	if (restoreSession())
+	{
+		current_state = RUN_MODE;
+		currIntervalSetIdx = intervalCount;
+		layer_set_hidden(runLayer, false);
+	}
+	else
+	{
+		//RUN IT!
+		runApp();
+	}
+	//Stop drawing while something covers the app
+	app_focus_service_subscribe(handle_focus);
+	//Connect the buttons for whichever screen we start on
+	setClickConfig();
+	//Only a running timer needs ticks
+	updateTickService();
 
 } //End handle_init
 
 /**
- * This handler gets called every second.
- * In run mode in makes the countdown tick
+ * This handler gets called every second while the run countdown is
+ * showing seconds. In run mode in makes the countdown tick
  */
 void handle_second_tick(struct tm *tick_time, TimeUnits units_changed)
 {
+	TRACE_EVENT(TRACE_TICK);
+	hudCount(HUD_WAKEUP);
+	hudTickStart();
 
 	if (current_state == RUN_MODE)
 	{
 		tick();
 	}
-} //End handle_second_tick
-
-/**
- * A timer handler. A timer is used to make the units
- * flash when setting the time. It's also used for vibrating! Yay, dual purpose!
- */
-void handle_timer_event()
-{
-	if (current_state == TIME_SET)
-	{
-		flashUnit();
 
-	}
-	else if (current_state == RUN_MODE)
-	{
-		doVibrate();
-	}
-
-} //End handle_time_event
+	hudTickEnd();
+} //End handle_second_tick
 
 /**
  * Main function called when the app starts
@@ -299,14 +391,15 @@ void nextState()
 		//Change state
 		current_state = TIME_SET;
 		//Start the time that flashes the units
-		app_timer_register(150, (AppTimerCallback) handle_timer_event, NULL);
+		startUnitFlash();
 		//Clear out the index for the interval time we're setting
 		currIntervalSetIdx = 0;
+		setClickConfig();
 		//Hide the current layer and show the next one.
 		layer_set_hidden(intervalLayer, true);
 		layer_set_hidden(setTimeLayer, false);
-		//Update the screen to show the cleared time.
-		updateSetTimeScreen();
+		//Show the time for the first interval.
+		markScreenDirty(DIRTY_SET_TIME);
 	}
 	else //In a time set stage
 	{
@@ -319,12 +412,18 @@ void nextState()
 			layer_set_hidden(runLayer, false);
 			//Set the new state
 			current_state = RUN_MODE;
+			//No more flashing in run mode
+			timerWheelCancel(TIMER_FLASH);
+			setClickConfig();
+			updateTickService();
 			activateRunMode();
+			//Keep the new run in case the app goes down mid run
+			startSession();
 		}
 		else //We just need to set the next interval time
 		{
 			currIntervalSetIdx++;
-			updateSetTimeScreen();
+			markScreenDirty(DIRTY_SET_TIME);
 		}
 	}
 
@@ -340,15 +439,17 @@ void prevState()
 		//Only go to the previous state from run mode if the timer is paused
 		if (!isRunning())
 		{
-			//Switch to time_set mode
+			//Switch to time_set mode. The saved run is no good after this.
+			clearSession();
 			current_state = TIME_SET;
+			setClickConfig();
+			updateTickService();
 			//Start the timer for unit flashing
-			app_timer_register(150, (AppTimerCallback) handle_timer_event,
-					NULL);
+			startUnitFlash();
 			currIntervalSetIdx--;
 			layer_set_hidden(runLayer, true);
 			layer_set_hidden(setTimeLayer, false);
-			updateSetTimeScreen();
+			markScreenDirty(DIRTY_SET_TIME);
 		}
 	}
 	else if (current_state == INTERVAL_COUNT)
@@ -361,11 +462,13 @@ void prevState()
 		if ((currIntervalSetIdx - 1) >= 0)
 		{
 			currIntervalSetIdx--;
-			updateSetTimeScreen();
+			markScreenDirty(DIRTY_SET_TIME);
 		}
 		else //There are no more time set screens, go back to the interval set screen
 		{
 			current_state = INTERVAL_COUNT;
+			timerWheelCancel(TIMER_FLASH);
+			setClickConfig();
 			layer_set_hidden(setTimeLayer, true);
 			layer_set_hidden(intervalLayer, false);
 		}
@@ -373,6 +476,24 @@ void prevState()
 
 } //End prevState
 
+/**
+ * Connect the buttons for run mode. There is no double press here,
+ * so a single press of select doesn't have to wait out the
+ * double press timeout before the timer starts or stops.
+ */
+void run_click_provider(Window *window)
+{
+	window_single_click_subscribe(BUTTON_ID_SELECT,
+			(ClickHandler) select_pressed);
+	window_long_click_subscribe(BUTTON_ID_SELECT, 0,
+			(ClickHandler) select_long_press, NULL);
+
+	window_single_repeating_click_subscribe(BUTTON_ID_UP, 200,
+			(ClickHandler) button_pressed_up);
+	window_single_repeating_click_subscribe(BUTTON_ID_DOWN, 200,
+			(ClickHandler) button_pressed_down);
+} //End run_click_provider
+
 void runApp()
 {
 	//Start the app by showing the interval layer.
@@ -384,6 +505,8 @@ void runApp()
  */
 void select_double_press(ClickRecognizerRef rec)
 {
+	TRACE_EVENT(TRACE_SELECT_DOUBLE);
+
 	if (current_state == TIME_SET || current_state == INTERVAL_COUNT)
 	{
 		nextState();
@@ -396,6 +519,8 @@ void select_double_press(ClickRecognizerRef rec)
  */
 void select_long_press(ClickRecognizerRef rec)
 {
+	TRACE_EVENT(TRACE_SELECT_LONG);
+
 	prevState();
 } //End select_long_press
 
@@ -406,6 +531,8 @@ void select_long_press(ClickRecognizerRef rec)
  */
 void select_pressed(ClickRecognizerRef rec)
 {
+	TRACE_EVENT(TRACE_SELECT);
+
 	if (current_state == RUN_MODE)
 	{
 		toggleRunning();
@@ -417,6 +544,41 @@ void select_pressed(ClickRecognizerRef rec)
 } //End selected_pressed
 
 
+/**
+ * Connect the buttons the way the current state needs them.
+ * Called whenever the state changes.
+ */
+void setClickConfig()
+{
+	//A button held down in the time set screens stops repeating when they are left.
+	if (current_state != TIME_SET)
+	{
+		stopTimeSetHold();
+	}
+
+	//A replayed trace supplies the button presses
+	if (traceIsReplaying())
+	{
+		return;
+	}
+
+	if (current_state == INTERVAL_COUNT)
+	{
+		window_set_click_config_provider(window,
+				(ClickConfigProvider) count_click_provider);
+	}
+	else if (current_state == TIME_SET)
+	{
+		window_set_click_config_provider(window,
+				(ClickConfigProvider) time_set_click_provider);
+	}
+	else
+	{
+		window_set_click_config_provider(window,
+				(ClickConfigProvider) run_click_provider);
+	}
+} //End setClickConfig
+
 /**
  * Sets the number of intervals we will be using.
  */
@@ -424,3 +586,62 @@ void setIntervalCount(uint8_t ct)
 {
 	intervalCount = ct;
 }
+
+/**
+ * Connect the buttons for the time set screens.
+ * Up and down are raw so the repeat rate and step size
+ * can grow the longer they are held.
+ */
+void time_set_click_provider(Window *window)
+{
+	window_single_click_subscribe(BUTTON_ID_SELECT,
+			(ClickHandler) select_pressed);
+	window_long_click_subscribe(BUTTON_ID_SELECT, 0,
+			(ClickHandler) select_long_press, NULL);
+	window_multi_click_subscribe(BUTTON_ID_SELECT, 2, 2, 100, true,
+			(ClickHandler) select_double_press);
+
+	window_raw_click_subscribe(BUTTON_ID_UP, (ClickHandler) button_held_up,
+			(ClickHandler) button_released, NULL);
+	window_raw_click_subscribe(BUTTON_ID_DOWN, (ClickHandler) button_held_down,
+			(ClickHandler) button_released, NULL);
+} //End time_set_click_provider
+
+/**
+ * Subscribe to the tick service when the screen needs it. Only a
+ * running timer that can be seen needs ticks at all, and only while the
+ * run screen shows seconds. The minutes only display is redrawn by the
+ * timer wheel.
+ */
+void updateTickService()
+{
+	static TimeUnits tickUnits = 0;
+	TimeUnits wanted = 0;
+
+	//A replayed trace supplies the ticks
+	if (traceIsReplaying())
+	{
+		return;
+	}
+
+	//Ticks only redraw the screen, so none while it can't be seen.
+	if (current_state == RUN_MODE && isRunning() && !isRenderingSuspended())
+	{
+		//The low power display is redrawn by the timer wheel instead.
+		wanted = isMinuteDisplay() ? 0 : SECOND_UNIT;
+	}
+	if (wanted == tickUnits)
+	{
+		return;
+	}
+
+	tickUnits = wanted;
+	if (wanted == 0)
+	{
+		tick_timer_service_unsubscribe();
+	}
+	else
+	{
+		tick_timer_service_subscribe(wanted, handle_second_tick);
+	}
+} //End updateTickService
@@ -0,0 +1,192 @@
+/**
+ * File: layout.c
+ * @author agent <agent@local>
+ *
+ * Text drawing shared by the screens. Every screen used to be a stack of
+ * TextLayers. Now each one is a single layer with an update proc that
+ * draws its text straight into the graphics context.
+ *
+ * Each screen describes its text in a const table (frame, font key,
+ * alignment and text) that stays in flash. buildLayout() turns a table
+ * into TextLayouts once, which only means looking up the fonts.
+ *
+ * The big digits (the run countdown and the set screen minutes/seconds)
+ * change every second, so they skip the font engine. They are copied out
+ * of a pre-drawn atlas of the ten digits and the colon (res/digits.png).
+ * Every digit is the same width so a digit always lands in the same cell.
+ *
+ */
+#include <pebble.h>
+#include <pebble_fonts.h>
+#include "../includes/hud.h"
+#include "../includes/layout.h"
+
+//Glyph sizes in the atlas. The digits come first, then the colon.
+#define DIGIT_WIDTH 26
+#define COLON_WIDTH 10
+#define DIGIT_HEIGHT 32
+#define COLON_GLYPH 10
+
+//The whole atlas, and a sub bitmap for each glyph in it.
+static GBitmap *digitAtlas = NULL;
+static GBitmap *digitGlyphs[COLON_GLYPH + 1];
+
+/**
+ * Which glyph a character is drawn with, or -1 if it isn't in the atlas.
+ */
+static int8_t glyphFor(char c)
+{
+	if (c >= '0' && c <= '9')
+	{
+		return c - '0';
+	}
+	if (c == ':')
+	{
+		return COLON_GLYPH;
+	}
+	return -1;
+}
+
+/**
+ * Draw a string of digits and colons from the atlas. The glyphs are
+ * lined up in the layout's frame by its alignment and centered
+ * vertically. Anything else in the string is skipped.
+ */
+static void drawDigits(GContext *ctx, const TextLayout *layout)
+{
+	GRect frame = layout->frame;
+	int16_t width = 0, x, y;
+	int8_t glyph;
+	const char *c;
+
+	//How wide the whole string is
+	for (c = layout->text; *c != 0; c++)
+	{
+		glyph = glyphFor(*c);
+		if (glyph >= 0)
+		{
+			width += (glyph == COLON_GLYPH) ? COLON_WIDTH : DIGIT_WIDTH;
+		}
+	}
+
+	if (layout->alignment == GTextAlignmentRight)
+	{
+		x = frame.origin.x + frame.size.w - width;
+	}
+	else if (layout->alignment == GTextAlignmentCenter)
+	{
+		x = frame.origin.x + (frame.size.w - width) / 2;
+	}
+	else
+	{
+		x = frame.origin.x;
+	}
+	y = frame.origin.y + (frame.size.h - DIGIT_HEIGHT) / 2;
+	hudCount(HUD_TEXT_DRAW);
+
+	for (c = layout->text; *c != 0; c++)
+	{
+		glyph = glyphFor(*c);
+		if (glyph < 0)
+		{
+			continue;
+		}
+		width = (glyph == COLON_GLYPH) ? COLON_WIDTH : DIGIT_WIDTH;
+		graphics_draw_bitmap_in_rect(ctx, digitGlyphs[glyph],
+				GRect(x, y, width, DIGIT_HEIGHT));
+		x += width;
+	}
+} //End drawDigits
+
+/**
+ * Fill in TextLayouts from a layout table.
+ *
+ * @param desc - the table
+ * @param layout - the TextLayouts to fill in, one per table entry
+ * @param count - how many entries there are
+ */
+void buildLayout(const TextLayoutDesc *desc, TextLayout *layout,
+		uint8_t count)
+{
+	uint8_t i;
+
+	for (i = 0; i < count; i++)
+	{
+		layout[i].frame = desc[i].frame;
+		layout[i].font = (desc[i].fontKey == NULL) ?
+				NULL : fonts_get_system_font(desc[i].fontKey);
+		layout[i].alignment = desc[i].alignment;
+		layout[i].text = desc[i].text;
+	}
+}
+
+/**
+ * Free the digit atlas. Called when the app closes.
+ */
+void deinitDigitAtlas()
+{
+	uint8_t i;
+
+	if (digitAtlas == NULL)
+	{
+		return;
+	}
+	for (i = 0; i <= COLON_GLYPH; i++)
+	{
+		gbitmap_destroy(digitGlyphs[i]);
+	}
+	gbitmap_destroy(digitAtlas);
+	digitAtlas = NULL;
+}
+
+/**
+ * Draw one piece of text where its layout says, from the digit atlas
+ * if it has no font. Nothing is drawn if it has no text.
+ * The text color must already be set on the context.
+ */
+void drawLayout(GContext *ctx, const TextLayout *layout)
+{
+	if (layout->text == NULL)
+	{
+		return;
+	}
+	if (layout->font == NULL)
+	{
+		drawDigits(ctx, layout);
+		return;
+	}
+	hudCount(HUD_TEXT_DRAW);
+	graphics_draw_text(ctx, layout->text, layout->font, layout->frame,
+			GTextOverflowModeWordWrap, layout->alignment, NULL);
+}
+
+/**
+ * Draw every piece of text in a list of layouts.
+ */
+void drawLayouts(GContext *ctx, const TextLayout *layout, uint8_t count)
+{
+	uint8_t i;
+
+	for (i = 0; i < count; i++)
+	{
+		drawLayout(ctx, &layout[i]);
+	}
+}
+
+/**
+ * Load the digit atlas and cut it into glyphs. This happens once,
+ * before any screen is drawn.
+ */
+void initDigitAtlas()
+{
+	uint8_t i;
+
+	digitAtlas = gbitmap_create_with_resource(RESOURCE_ID_DIGIT_ATLAS);
+	for (i = 0; i < COLON_GLYPH; i++)
+	{
+		digitGlyphs[i] = gbitmap_create_as_sub_bitmap(digitAtlas,
+				GRect(i * DIGIT_WIDTH, 0, DIGIT_WIDTH, DIGIT_HEIGHT));
+	}
+	digitGlyphs[COLON_GLYPH] = gbitmap_create_as_sub_bitmap(digitAtlas,
+			GRect(COLON_GLYPH * DIGIT_WIDTH, 0, COLON_WIDTH, DIGIT_HEIGHT));
+} //End initDigitAtlas
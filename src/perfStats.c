@@ -0,0 +1,194 @@
+/**
+ * File: perfStats.c
+ * @author agent <agent@local>
+ *
+ * Render cost statistics for debug builds.
+ *
+ * Marking a screen layer dirty redraws the whole layer, even when only one
+ * digit actually changed. This file remembers what each piece of text last
+ * showed so each update can be scored on how many pixels it redrew versus
+ * how many it really needed to change. The numbers are written to the app
+ * log once per update ("frame").
+ *
+ * Changed pixels are estimated from the character cells that changed. Each
+ * character is assumed to take an equal share of the text's frame.
+ *
+ */
+#include <pebble.h>
+#include "../includes/perfStats.h"
+
+#ifdef INTERVALS_DEBUG
+
+//How many pieces of text we can keep track of. The app has 12.
+#define TRACKED_TEXT_COUNT 16
+//Longest text we remember ("Interval 00" plus the terminator)
+#define TRACKED_TEXT_MAX 12
+
+//What a piece of text showed the last time it was drawn.
+typedef struct
+{
+	const TextLayout *layout;
+	char text[TRACKED_TEXT_MAX];
+	bool shown;
+} TrackedText;
+
+//Counters for the frame in progress and for the whole run.
+typedef struct
+{
+	uint8_t layersUpdated;
+	uint32_t pixelsRedrawn;
+	uint32_t pixelsChanged;
+	int16_t dirtyX1, dirtyY1, dirtyX2, dirtyY2;
+	uint32_t frames;
+	uint32_t totalRedrawn;
+	uint32_t totalChanged;
+} RenderStats;
+
+static TrackedText trackedTexts[TRACKED_TEXT_COUNT];
+static uint8_t trackedCount = 0;
+static RenderStats stats;
+
+/**
+ * Find the record for a piece of text, adding one if it is new.
+ */
+static TrackedText * findTrackedText(const TextLayout *layout)
+{
+	uint8_t i;
+	for (i = 0; i < trackedCount; i++)
+	{
+		if (trackedTexts[i].layout == layout)
+		{
+			return &trackedTexts[i];
+		}
+	}
+	if (trackedCount == TRACKED_TEXT_COUNT)
+	{
+		return NULL;
+	}
+	trackedTexts[trackedCount].layout = layout;
+	trackedTexts[trackedCount].text[0] = 0;
+	trackedTexts[trackedCount].shown = true;
+	return &trackedTexts[trackedCount++];
+}
+
+/**
+ * Close out the current frame and write its numbers to the log.
+ *
+ * @param source - the name of the function that did the update
+ */
+void perfStatsEndFrame(const char *source)
+{
+	uint32_t dirtyArea = 0;
+
+	if (stats.layersUpdated > 0)
+	{
+		dirtyArea = (stats.dirtyX2 - stats.dirtyX1)
+				* (stats.dirtyY2 - stats.dirtyY1);
+	}
+	stats.frames++;
+	stats.totalRedrawn += stats.pixelsRedrawn;
+	stats.totalChanged += stats.pixelsChanged;
+
+	APP_LOG(APP_LOG_LEVEL_DEBUG,
+			"%s: %d layers, %lu px redrawn, ~%lu px changed, dirty rect %lu px",
+			source, stats.layersUpdated, (unsigned long) stats.pixelsRedrawn,
+			(unsigned long) stats.pixelsChanged, (unsigned long) dirtyArea);
+	APP_LOG(APP_LOG_LEVEL_DEBUG, "frames %lu, avg %lu px redrawn, ~%lu px changed",
+			(unsigned long) stats.frames,
+			(unsigned long) (stats.totalRedrawn / stats.frames),
+			(unsigned long) (stats.totalChanged / stats.frames));
+
+	stats.layersUpdated = 0;
+	stats.pixelsRedrawn = 0;
+	stats.pixelsChanged = 0;
+} //End perfStatsEndFrame
+
+/**
+ * Add a layer that was marked dirty to the frame in progress.
+ */
+void perfStatsRedraw(Layer *layer)
+{
+	GRect frame = layer_get_frame(layer);
+	int16_t x2 = frame.origin.x + frame.size.w;
+	int16_t y2 = frame.origin.y + frame.size.h;
+
+	if (stats.layersUpdated == 0)
+	{
+		stats.dirtyX1 = frame.origin.x;
+		stats.dirtyY1 = frame.origin.y;
+		stats.dirtyX2 = x2;
+		stats.dirtyY2 = y2;
+	}
+	else
+	{
+		//Grow the dirty rect so it covers this layer too.
+		if (frame.origin.x < stats.dirtyX1)
+			stats.dirtyX1 = frame.origin.x;
+		if (frame.origin.y < stats.dirtyY1)
+			stats.dirtyY1 = frame.origin.y;
+		if (x2 > stats.dirtyX2)
+			stats.dirtyX2 = x2;
+		if (y2 > stats.dirtyY2)
+			stats.dirtyY2 = y2;
+	}
+	stats.layersUpdated++;
+	stats.pixelsRedrawn += frame.size.w * frame.size.h;
+} //End perfStatsRedraw
+
+/**
+ * Score a piece of text being shown or hidden (the flashing units).
+ * That touches every pixel of its frame.
+ */
+void perfStatsShown(const TextLayout *layout, bool shown)
+{
+	TrackedText *tracked = findTrackedText(layout);
+
+	if (tracked != NULL && tracked->shown == shown)
+	{
+		return;
+	}
+	if (tracked != NULL)
+	{
+		tracked->shown = shown;
+	}
+	stats.pixelsChanged += layout->frame.size.w * layout->frame.size.h;
+} //End perfStatsShown
+
+/**
+ * Score the change to a piece of text.
+ */
+void perfStatsText(const TextLayout *layout, const char *text)
+{
+	TrackedText *tracked = findTrackedText(layout);
+	uint32_t area = layout->frame.size.w * layout->frame.size.h;
+	uint8_t i, oldLen, newLen, len, changedChars = 0;
+
+	if (tracked == NULL)
+	{
+		stats.pixelsChanged += area;
+		return;
+	}
+
+	//Count the character cells that differ from last time.
+	oldLen = strlen(tracked->text);
+	for (newLen = 0; newLen < TRACKED_TEXT_MAX - 1 && text[newLen] != 0; newLen++)
+		;
+	len = (oldLen > newLen) ? oldLen : newLen;
+	for (i = 0; i < len; i++)
+	{
+		if (i >= oldLen || i >= newLen || text[i] != tracked->text[i])
+		{
+			changedChars++;
+		}
+	}
+	memcpy(tracked->text, text, newLen);
+	tracked->text[newLen] = 0;
+
+	if (len == 0)
+	{
+		len = 1;
+	}
+	stats.pixelsChanged += area * changedChars / len;
+} //End perfStatsText
+
+#endif
@@ -0,0 +1,89 @@
+/**
+ * File: powerPolicy.c
+ * @author agent <agent@local>
+ *
+ * The one place that decides what the app may spend power on. Everything
+ * that could be cut back (unit flashing, the run display, vibrations)
+ * asks powerPolicy() rather than checking the battery itself.
+ *
+ * Once the battery is down to ECONOMY_BATTERY_PERCENT the economy policy
+ * takes over: the units stop flashing, the run display only shows minutes
+ * while far from the end of an interval, and the vibrations are shorter.
+ * Plugging the watch in goes back to the normal policy.
+ *
+ */
+#include <pebble.h>
+#include "../includes/config.h"
+#include "../includes/types.h"
+#include "../includes/intervals.h"
+#include "../includes/powerPolicy.h"
+#include "../includes/runScreen.h"
+#include "../includes/timeSetScreen.h"
+
+static const PowerPolicy normalPolicy =
+{ .flashUnits = true, .minuteDisplay = LOW_POWER_DISPLAY, .shortVibes = false };
+
+static const PowerPolicy economyPolicy =
+{ .flashUnits = false, .minuteDisplay = true, .shortVibes = true };
+
+static const PowerPolicy *currentPolicy = &normalPolicy;
+
+/**
+ * The policy for a battery state.
+ */
+static const PowerPolicy * policyFor(BatteryChargeState charge)
+{
+	if (!charge.is_charging && !charge.is_plugged
+			&& charge.charge_percent <= ECONOMY_BATTERY_PERCENT)
+	{
+		return &economyPolicy;
+	}
+	return &normalPolicy;
+}
+
+/**
+ * Called by the battery state service. Switches policy if needed
+ * and lets the screens catch up.
+ */
+static void handleBatteryState(BatteryChargeState charge)
+{
+	const PowerPolicy *policy = policyFor(charge);
+
+	if (policy == currentPolicy)
+	{
+		return;
+	}
+	currentPolicy = policy;
+
+	updateRunPowerPolicy();
+	if (getCurrState() == TIME_SET)
+	{
+		startUnitFlash();
+	}
+}
+
+/**
+ * The policy in force right now.
+ */
+const PowerPolicy * powerPolicy()
+{
+	return currentPolicy;
+}
+
+/**
+ * Stop watching the battery. Called when the app closes.
+ */
+void powerPolicyDeinit()
+{
+	battery_state_service_unsubscribe();
+}
+
+/**
+ * Pick the policy for the battery as it is now and start watching it.
+ * Called before anything asks for the policy.
+ */
+void powerPolicyInit()
+{
+	currentPolicy = policyFor(battery_state_service_peek());
+	battery_state_service_subscribe(handleBatteryState);
+}
@@ -0,0 +1,94 @@
+/**
+ * File: render.c
+ * @author agent <agent@local>
+ *
+ * Button presses, repeats and the unit flash don't format or draw anything
+ * themselves. They only mark their screen's layer dirty. Pebble draws the
+ * dirty layers once per frame, and the set screens work their text out
+ * from the current state in their update procs, so a burst of changes
+ * inside one frame costs a single redraw and no wakeup of its own.
+ *
+ * The run screen changes at most once a second and only from a tick or a
+ * timer that has already woken the app, so it works its text out as it
+ * goes and marks runLayer dirty itself.
+ *
+ * While the app is covered by a notification or another window, rendering
+ * is suspended and nothing is marked dirty. When the app is back in focus
+ * the screen being shown is redrawn once. The hidden screens are redrawn
+ * when they are shown.
+ *
+ */
+#include <pebble.h>
+#include "../includes/types.h"
+#include "../includes/runScreen.h"
+#include "../includes/render.h"
+
+//The screen layers from intervals.c
+extern Layer *intervalLayer, *runLayer, *setTimeLayer;
+
+//Set while the app is out of focus.
+static bool suspended = false;
+
+/**
+ * The layer a screen is drawn in.
+ */
+static Layer * screenLayer(DirtyScreen screen)
+{
+	switch (screen)
+	{
+	case DIRTY_INTERVAL_COUNT:
+		return intervalLayer;
+	case DIRTY_SET_TIME:
+		return setTimeLayer;
+	default:
+		return runLayer;
+	}
+}
+
+/**
+ * Returns true while nothing is being redrawn.
+ */
+bool isRenderingSuspended()
+{
+	return suspended;
+}
+
+/**
+ * Note that a screen needs to be redrawn. Pebble redraws it
+ * with the next frame.
+ */
+void markScreenDirty(DirtyScreen screen)
+{
+	if (!suspended)
+	{
+		layer_mark_dirty(screenLayer(screen));
+	}
+}
+
+/**
+ * Start redrawing again. The screen being shown is redrawn straight
+ * away. The others are redrawn when they are next shown.
+ *
+ * @param screen - the screen being shown
+ */
+void resumeRendering(DirtyScreen screen)
+{
+	suspended = false;
+	if (screen == DIRTY_RUN)
+	{
+		//The run screen's text is worked out before it is marked dirty.
+		updateRunTimeScreen();
+	}
+	else
+	{
+		markScreenDirty(screen);
+	}
+}
+
+/**
+ * Stop redrawing until resumeRendering() is called.
+ */
+void suspendRendering()
+{
+	suspended = true;
+}
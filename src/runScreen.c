@@ -11,13 +11,48 @@
  */
 #include <pebble.h>
 #include <pebble_fonts.h>
+#include "../includes/config.h"
 #include "../includes/types.h"
+#include "../includes/hud.h"
 #include "../includes/intervals.h"
+#include "../includes/layout.h"
+#include "../includes/perfStats.h"
+#include "../includes/powerPolicy.h"
+#include "../includes/render.h"
 #include "../includes/runScreen.h"
+#include "../includes/session.h"
+#include "../includes/timerWheel.h"
 
 //Reference to the pointer for this layer from intervals.c
 extern Layer *runLayer;
 
+#ifdef VIBE_FIVES
+//Enough long pulses for 99 intervals.
+#define VIBE_MAX_LONGS 19
+//vibeCount for the end of the last interval.
+#define VIBE_WRAP 0xFF
+
+/*
+ Every five/one pattern is a window into one of these tables: the last few
+ long pulses followed by the first few short ones. So one pattern is
+ handed to the motor per boundary. l, s and g are the long pulse, short
+ pulse and gap in ms.
+ */
+#define VIBE_5_LONGS(l, g) l, g, l, g, l, g, l, g, l, g
+#define VIBE_FIVES_TABLE(l, s, g) \
+{ VIBE_5_LONGS(l, g), VIBE_5_LONGS(l, g), VIBE_5_LONGS(l, g), \
+		l, g, l, g, l, g, l, g, s, g, s, g, s, g, s }
+
+static const uint32_t vibeFives[] = VIBE_FIVES_TABLE(300, 100, 200);
+//Economy mode.
+static const uint32_t vibeFivesShort[] = VIBE_FIVES_TABLE(200, 60, 200);
+
+//The quick buzz for going back round to the first interval.
+static const uint32_t vibeWrap[] =
+{ 60, 60, 60, 60, 60, 60, 60 };
+static const uint32_t vibeWrapShort[] =
+{ 60, 60, 60 };
+#else
 //The pattern to use for the vibration.
 
 const VibePattern vibeSeq =
@@ -28,106 +63,491 @@ const VibePattern vibeSeq =
 				.num_segments = 1
 			};
 
-//Visual elements for this screen.
-TextLayer *runModeTitleTextLayer, *runModeIntervalTextLayer;
-TextLayer *runModeIntRunTimeTextLayer, *runModeTotalRunTimeTextLayer;
+//The pattern for economy mode.
+static const uint32_t vibeShortDurations[] =
+{ 80 };
+const VibePattern vibeSeqShort =
+{ .durations = vibeShortDurations, .num_segments = 1 };
+#endif
 
 //Flag to indicate if the timers are running
 bool isRunningFlag = false;
 //The interval that is currently active
 uint8_t currRunInt = 0;
-//Timer counters! (Now  32 bit for even more overflow protection!)
-uint32_t currSecCount = 0, totalRunCount = 0;
+/*
+ All times are in ms of timerWheelNow() time.
+ While running, intervalStartMs is when the current interval started,
+ moved forward by however long it was paused. While paused, pausedElapsedMs
+ is how far into the interval we were.
+ */
+uint32_t intervalStartMs = 0, pausedElapsedMs = 0;
+//Run time banked at the last pause, and when the timer was last started.
+uint32_t totalRunMs = 0, runStartMs = 0;
+//How far into the interval the screen last showed, for a clock change.
+uint32_t shownElapsedMs = 0;
 //Counter for how many vibrations to pulse.
 uint8_t vibeCount = 0;
 char timeStringText[6];
 char runTimeStringText[9];
 
+//The text on this screen. The interval title is filled in when it is built.
+enum
+{
+	RUN_MODE_TEXT, RUN_TITLE, RUN_COUNTDOWN, RUN_UNIT, RUN_TOTAL, RUN_TEXT_TOTAL
+};
+static const TextLayoutDesc runLayoutDesc[RUN_TEXT_TOTAL] =
+{
+//Current layer lable
+{ LAYOUT_FRAME(0, 15, SCREEN_WIDTH, 40), FONT_KEY_GOTHIC_24_BOLD,
+		GTextAlignmentCenter, "Run Mode" },
+//Current interval text
+{ LAYOUT_FRAME(0, 40, SCREEN_WIDTH, 40), FONT_KEY_GOTHIC_24_BOLD,
+		GTextAlignmentCenter, NULL },
+//The countdown, drawn from the digit atlas
+{ LAYOUT_FRAME(0, 80, SCREEN_WIDTH, 50), NULL, GTextAlignmentCenter,
+		timeStringText },
+//The unit after the minutes of the low power display, hidden otherwise
+{ LAYOUT_FRAME(SCREEN_WIDTH / 2 + 30, 88, 40, 24), FONT_KEY_GOTHIC_18,
+		GTextAlignmentLeft, NULL },
+//The countup
+{ LAYOUT_FRAME(0, 130, SCREEN_WIDTH, 40), FONT_KEY_GOTHIC_18,
+		GTextAlignmentCenter, runTimeStringText } };
+static TextLayout runLayout[RUN_TEXT_TOTAL];
+
+/**
+ * How long an interval lasts in ms. The countdown shows the set time
+ * down to 00:00, one second each, so that is one second more than the set time.
+ */
+static uint32_t intervalLength(uint8_t idx)
+{
+	return (getIntervals()[idx] + 1) * 1000;
+}
+
+#ifdef RUN_PROGRESS_BAR
+//Where the progress bar goes, between the countdown and the countup.
+#define PROGRESS_FRAME GRect(20, 124 + LAYOUT_TOP, SCREEN_WIDTH - 40, 4)
+
+/**
+ * Draw how far through the current interval the run is.
+ */
+static void drawProgressBar(GContext *ctx)
+{
+	GRect frame = PROGRESS_FRAME;
+	uint32_t elapsedMs, totalMs;
+	uint8_t interval;
+
+	getRunState(&interval, &elapsedMs, &totalMs);
+	graphics_context_set_stroke_color(ctx, GColorBlack);
+	graphics_context_set_fill_color(ctx, GColorBlack);
+	graphics_draw_rect(ctx, frame);
+	//The interval can be just over while its end is on the way.
+	if (elapsedMs < intervalLength(interval))
+	{
+		frame.size.w = frame.size.w * elapsedMs / intervalLength(interval);
+	}
+	graphics_fill_rect(ctx, frame, 0, GCornerNone);
+}
+#endif
+
+/**
+ * Draw the whole screen. This is the update proc for runLayer.
+ */
+static void drawRunScreen(Layer *layer, GContext *ctx)
+{
+	graphics_context_set_text_color(ctx, GColorBlack);
+	drawLayouts(ctx, runLayout, RUN_TEXT_TOTAL);
+#ifdef RUN_PROGRESS_BAR
+	drawProgressBar(ctx);
+#endif
+}
+
+//How far before the interval start a time can be without being a clock
+//change. A tick is for the start of its second, which can be just before.
+#define CLOCK_JUMP_MS 1000
+
+static void scheduleIntervalEnd();
+
+/**
+ * The times here come from the watch clock, which can be changed under a
+ * running timer: a time sync, or a time zone or DST change where the clock
+ * is local time. If now is before the interval started, the clock went
+ * back. Move the run back with it, from where the screen last showed, and
+ * set the end up again so the interval doesn't run long.
+ *
+ * @param now - the time being looked at, in timerWheelNow() time
+ */
+static void catchClockJump(uint32_t now)
+{
+	uint32_t shift;
+
+	if (!isRunningFlag || (int32_t) (now - intervalStartMs) >= -CLOCK_JUMP_MS)
+	{
+		return;
+	}
+	shift = intervalStartMs - (now - shownElapsedMs);
+	intervalStartMs -= shift;
+	runStartMs -= shift;
+	scheduleIntervalEnd();
+}
+
+/**
+ * Show the timers as they were at a moment in time.
+ *
+ * @param now - the moment, in timerWheelNow() time
+ */
+static void showRunTime(uint32_t now)
+{
+	uint16_t *intervals = getIntervals();
+	char * setTimeTitleStr = getTimeTitleStr();
+	uint32_t elapsedSecs = 0, totalMs = totalRunMs, totalMins;
+	uint8_t minsLeft;
+
+	catchClockJump(now);
+	if (isRunningFlag)
+	{
+		//A tick for a second that started just before the interval did.
+		if ((int32_t) (now - intervalStartMs) > 0)
+		{
+			shownElapsedMs = now - intervalStartMs;
+			elapsedSecs = shownElapsedMs / 1000;
+		}
+		if ((int32_t) (now - runStartMs) > 0)
+		{
+			totalMs += now - runStartMs;
+		}
+	}
+	else
+	{
+		elapsedSecs = pausedElapsedMs / 1000;
+	}
+	if (elapsedSecs > intervals[currRunInt])
+	{
+		elapsedSecs = intervals[currRunInt];
+	}
+	if (isMinuteDisplay())
+	{
+		//Only the minutes left (rounded up) and the total in whole minutes,
+		//with units so neither can be read as minutes and seconds.
+		minsLeft = (intervals[currRunInt] - elapsedSecs + 59) / 60;
+		timeStringText[0] = (minsLeft / 10) + 48;
+		timeStringText[1] = (minsLeft % 10) + 48;
+		timeStringText[2] = 0;
+		runLayout[RUN_UNIT].text = "min";
+		totalMins = totalMs / 60000;
+		runTimeStringText[0] = (totalMins / 600 % 10) + 48;
+		runTimeStringText[1] = (totalMins / 60 % 10) + 48;
+		runTimeStringText[2] = 'h';
+		runTimeStringText[3] = ' ';
+		runTimeStringText[4] = (totalMins % 60 / 10) + 48;
+		runTimeStringText[5] = (totalMins % 10) + 48;
+		runTimeStringText[6] = 'm';
+		runTimeStringText[7] = 0;
+	}
+	else
+	{
+		//Get the seconds remaining in this interval
+		formatTime(intervals[currRunInt] - elapsedSecs, timeStringText, false);
+		runLayout[RUN_UNIT].text = NULL;
+		//Get the total time elapsed time string
+		formatTime(totalMs / 1000, runTimeStringText, true);
+	}
+	//Update the number of interval we're on.
+	if (currRunInt + 1 < 10)
+	{
+		setTimeTitleStr[9] = currRunInt + 1 + 48;
+		setTimeTitleStr[10] = 0;
+	}
+	else
+	{
+		setTimeTitleStr[9] = (currRunInt + 1) / 10 + 48;
+		setTimeTitleStr[10] = (currRunInt + 1) % 10 + 48;
+		setTimeTitleStr[11] = 0;
+	}
+
+	//Redraw the screen with the new text
+	perfStatsText(&runLayout[RUN_TITLE], setTimeTitleStr);
+	perfStatsText(&runLayout[RUN_COUNTDOWN], timeStringText);
+	perfStatsText(&runLayout[RUN_TOTAL], runTimeStringText);
+	layer_mark_dirty(runLayer);
+	perfStatsRedraw(runLayer);
+	perfStatsEndFrame("updateRunTimeScreen");
+} //End showRunTime
+
+/**
+ * Redraw the run screen now. It is only called from ticks, timers and
+ * single presses, which have already woken the app, so there is nothing
+ * to gain from waiting a frame. Focus coming back redraws it anyway.
+ */
+static void redrawRunScreen()
+{
+	if (!isRenderingSuspended())
+	{
+		updateRunTimeScreen();
+	}
+}
+
+static void refreshMinutes();
+
+/**
+ * Arm the timer wheel for the next change to the low power display: the
+ * minutes left going down by one, or the switch back to seconds exactly
+ * LOW_POWER_THRESHOLD_SECS before the end, whichever comes first. These
+ * follow the interval, not the wall clock, so the minutes are never stale.
+ */
+static void scheduleMinuteRefresh()
+{
+	uint32_t end = intervalStartMs + intervalLength(currRunInt);
+	uint32_t switchAt = end - LOW_POWER_THRESHOLD_SECS * 1000;
+	uint32_t secsLeft = getIntervals()[currRunInt]
+			- (timerWheelNow() - intervalStartMs) / 1000;
+	//The display shows secsLeft rounded up to minutes. It goes down one
+	//when secsLeft gets to the next whole minute below.
+	uint32_t next = end - 1000 - (secsLeft + 59) / 60 * 60000 + 60000;
+
+	if ((int32_t) (next - switchAt) > 0)
+	{
+		next = switchAt;
+	}
+	timerWheelSchedule(TIMER_GRANULARITY, next, refreshMinutes);
+}
+
+/**
+ * Called by the timer wheel when the low power display changes. Once the
+ * last stretch of the interval is reached, go back to a tick every second.
+ */
+static void refreshMinutes()
+{
+	if (isMinuteDisplay())
+	{
+		scheduleMinuteRefresh();
+	}
+	else
+	{
+		updateTickService();
+	}
+	redrawRunScreen();
+}
+
+/**
+ * Arm the timer wheel for the end of the current interval, and for the
+ * low power display's changes if it is showing. Only called while running.
+ */
+static void scheduleIntervalEnd()
+{
+	uint32_t end = intervalStartMs + intervalLength(currRunInt);
+
+	timerWheelSchedule(TIMER_PROGRAM, end, endInterval);
+	if (isMinuteDisplay())
+	{
+		scheduleMinuteRefresh();
+	}
+	else
+	{
+		timerWheelCancel(TIMER_GRANULARITY);
+	}
+	//Tick every second, unless the low power display is showing.
+	updateTickService();
+}
+
 /**
  * When run mode starts for we need to clear out
  * the acculmulator variables.
  */
 void activateRunMode()
 {
+	uint32_t now = timerWheelNow();
 	//Initialize stuff
 	//The countup timer
-	totalRunCount = 0;
+	totalRunMs = 0;
+	runStartMs = now;
 	//The interval we're currently in
 	currRunInt = 0;
-	//A countup counter for the seconds elapsed in this interval
-	currSecCount = 0;
+	//Start the interval from the top
+	intervalStartMs = now;
+	pausedElapsedMs = 0;
+	//Set the timers and ticks up for the current power policy.
+	if (isRunningFlag)
+	{
+		scheduleIntervalEnd();
+	}
 	//Redraw the new screen.
 	updateRunTimeScreen();
 }
 
 /**
- * Clean up on shut down.
+ * Move a running position forward through the intervals. The time is
+ * taken modulo a full cycle of intervals first, so however much time
+ * is added this only walks round the intervals once.
+ *
+ * @param interval - the interval the position is in, updated
+ * @param elapsedMs - how far into that interval it is, updated
+ * @param ms - how much time to add
  */
-void deinitRunScreen()
+void advanceRunPosition(uint8_t *interval, uint32_t *elapsedMs, uint32_t ms)
 {
-	text_layer_destroy(runModeTitleTextLayer);
-	text_layer_destroy(runModeIntervalTextLayer);
-	text_layer_destroy(runModeIntRunTimeTextLayer);
-	text_layer_destroy(runModeTotalRunTimeTextLayer);
-}
+	uint32_t cycleMs = 0, position = *elapsedMs;
+	uint8_t i, intervalCount = getIntervalCount();
+
+	//Where we are in a full cycle of the intervals, once the time is added.
+	for (i = 0; i < intervalCount; i++)
+	{
+		if (i < *interval)
+		{
+			position += intervalLength(i);
+		}
+		cycleMs += intervalLength(i);
+	}
+	position = (uint32_t) (((uint64_t) position + ms) % cycleMs);
+	//Find the interval that position lands in.
+	*interval = 0;
+	while (position >= intervalLength(*interval))
+	{
+		position -= intervalLength(*interval);
+		(*interval)++;
+	}
+	*elapsedMs = position;
+} //End advanceRunPosition
 
 /**
  * Make it vibrate!
  */
+#ifdef VIBE_FIVES
+void doVibrate()
+{
+	VibePattern pattern;
+	uint8_t longs = vibeCount / 5, shorts = vibeCount % 5;
+	bool shortVibes = powerPolicy()->shortVibes;
+
+	if (vibeCount == VIBE_WRAP && shortVibes)
+	{
+		pattern.durations = vibeWrapShort;
+		pattern.num_segments = sizeof(vibeWrapShort) / sizeof(vibeWrapShort[0]);
+	}
+	else if (vibeCount == VIBE_WRAP)
+	{
+		pattern.durations = vibeWrap;
+		pattern.num_segments = sizeof(vibeWrap) / sizeof(vibeWrap[0]);
+	}
+	else if (vibeCount > 0)
+	{
+		//The last few long pulses in the table, then as many short ones as needed.
+		pattern.durations = shortVibes ? vibeFivesShort : vibeFives;
+		pattern.durations += (VIBE_MAX_LONGS - longs) * 2;
+		pattern.num_segments = (longs + shorts) * 2 - 1;
+	}
+	else
+	{
+		return;
+	}
+	vibes_enqueue_custom_pattern(pattern);
+	vibeCount = 0;
+}
+#else
 void doVibrate()
 {
 	//See if we need to vibrate anymore.
 	if (vibeCount > 0)
 	{
-		vibes_enqueue_custom_pattern(vibeSeq);
+		vibes_enqueue_custom_pattern(
+				powerPolicy()->shortVibes ? vibeSeqShort : vibeSeq);
 		vibeCount--;
 		//Reload the timer for the next vibration
-		app_timer_register(200, (AppTimerCallback) handle_timer_event, NULL);
+		timerWheelScheduleIn(TIMER_VIBE, 200, doVibrate);
+		hudCount(HUD_VIBE_TIMER);
 	}
 }
+#endif
+
+/**
+ * Called by the timer wheel when the current interval runs out.
+ * The next interval starts exactly where this one ended, however
+ * late the wakeup was. If the clock was moved forward past more
+ * boundaries than that, the run is moved on to where it is now in
+ * one go, the same as resumeRunMode() does, with a single vibration.
+ */
+void endInterval()
+{
+	uint32_t now = timerWheelNow();
+	uint32_t elapsedMs = now - intervalStartMs;
+	uint8_t interval = currRunInt;
+
+	//Find the interval we're in now. Normally that's the next one, starting
+	//where this one ended.
+	advanceRunPosition(&interval, &elapsedMs, 0);
+	intervalStartMs = now - elapsedMs;
+	currRunInt = interval;
+	//This will vibrate the same number of interval we just finished
+	vibeCount = (currRunInt == 0) ? getIntervalCount() : currRunInt;
+#ifdef VIBE_FIVES
+	//Going back round to the first one has its own pattern.
+	if (currRunInt == 0)
+	{
+		vibeCount = VIBE_WRAP;
+	}
+#endif
+	//Start the vibrating
+	doVibrate();
+
+	scheduleIntervalEnd();
+	//Update the screen
+	redrawRunScreen();
+	logSessionEvent(SESSION_BOUNDARY);
+} //End endInterval
+
+/**
+ * Get where the run is up to, for saving it.
+ *
+ * @param interval - set to the current interval
+ * @param elapsedMs - set to how far into that interval we are
+ * @param totalMs - set to the total run time so far
+ */
+void getRunState(uint8_t *interval, uint32_t *elapsedMs, uint32_t *totalMs)
+{
+	uint32_t now = timerWheelNow();
+
+	*interval = currRunInt;
+	if (isRunningFlag)
+	{
+		*elapsedMs = now - intervalStartMs;
+		*totalMs = totalRunMs + now - runStartMs;
+	}
+	else
+	{
+		*elapsedMs = pausedElapsedMs;
+		*totalMs = totalRunMs;
+	}
+} //End getRunState
 
 /**
  * Build the screen
  */
 void initRunScreen()
 {
-	char * setTimeTitleStr = getTimeTitleStr();
 	//Hide it by default.
 	layer_set_hidden(runLayer, true);
 
-	//Current layer lable
-	runModeTitleTextLayer = text_layer_create(GRect(0, 15, 144, 40));
-	text_layer_set_text(runModeTitleTextLayer, "Run Mode");
-	text_layer_set_font(runModeTitleTextLayer,
-			fonts_get_system_font(FONT_KEY_GOTHIC_24_BOLD));
-	text_layer_set_text_alignment(runModeTitleTextLayer, GTextAlignmentCenter);
-	layer_add_child(runLayer, text_layer_get_layer(runModeTitleTextLayer));
-
-	//Current interval text
-	runModeIntervalTextLayer = text_layer_create(GRect(0, 40, 144, 40));
-	text_layer_set_text(runModeIntervalTextLayer, setTimeTitleStr);
-	text_layer_set_font(runModeIntervalTextLayer,
-			fonts_get_system_font(FONT_KEY_GOTHIC_24_BOLD));
-	text_layer_set_text_alignment(runModeIntervalTextLayer,
-			GTextAlignmentCenter);
-	layer_add_child(runLayer, text_layer_get_layer(runModeIntervalTextLayer));
-
-	//Create the countdown layer
-	runModeIntRunTimeTextLayer = text_layer_create(GRect(0, 80, 144, 50));
-	text_layer_set_font(runModeIntRunTimeTextLayer,
-			fonts_get_system_font(FONT_KEY_BITHAM_42_BOLD));
-	text_layer_set_text_alignment(runModeIntRunTimeTextLayer,
-			GTextAlignmentCenter);
-	layer_add_child(runLayer, text_layer_get_layer(runModeIntRunTimeTextLayer));
-
-	//Create the countup layer
-	runModeTotalRunTimeTextLayer = text_layer_create(GRect(0, 130, 144, 40));
-	text_layer_set_font(runModeTotalRunTimeTextLayer,
-			fonts_get_system_font(FONT_KEY_GOTHIC_18));
-	text_layer_set_text_alignment(runModeTotalRunTimeTextLayer,
-			GTextAlignmentCenter);
-	layer_add_child(runLayer,
-			text_layer_get_layer(runModeTotalRunTimeTextLayer));
+	buildLayout(runLayoutDesc, runLayout, RUN_TEXT_TOTAL);
+	runLayout[RUN_TITLE].text = getTimeTitleStr();
+	layer_set_update_proc(runLayer, drawRunScreen);
+}
+
+/**
+ * Returns true if the run screen only needs to change once a minute:
+ * the low power display is on, the timer is running and the end of the
+ * interval is more than LOW_POWER_THRESHOLD_SECS away.
+ */
+bool isMinuteDisplay()
+{
+	uint32_t now = timerWheelNow();
+	uint32_t end;
+
+	if (!powerPolicy()->minuteDisplay || !isRunningFlag)
+	{
+		return false;
+	}
+	catchClockJump(now);
+	end = intervalStartMs + intervalLength(currRunInt);
+	return (int32_t) (end - now) > LOW_POWER_THRESHOLD_SECS * 1000;
 }
 
 /**
@@ -138,20 +558,64 @@ bool isRunning()
 	return isRunningFlag;
 }
 
+/**
+ * Pick up a saved run. If it was running, it is moved forward by
+ * however long the app was closed in one go: the time is taken
+ * modulo a full cycle of intervals and then placed in the right
+ * interval. No seconds are replayed and no boundaries vibrate.
+ *
+ * @param interval - the interval the run was in when it was saved
+ * @param elapsedMs - how far into that interval it was
+ * @param totalMs - the total run time when it was saved
+ * @param running - whether the timer was running
+ * @param closedMs - how long the app has been closed
+ */
+void resumeRunMode(uint8_t interval, uint32_t elapsedMs, uint32_t totalMs,
+		bool running, uint32_t closedMs)
+{
+	uint32_t now = timerWheelNow();
+
+	if (interval >= getIntervalCount())
+	{
+		interval = 0;
+		elapsedMs = 0;
+	}
+	if (running)
+	{
+		advanceRunPosition(&interval, &elapsedMs, closedMs);
+		totalMs += closedMs;
+	}
+
+	currRunInt = interval;
+	isRunningFlag = running;
+	totalRunMs = totalMs;
+	runStartMs = now;
+	intervalStartMs = now - elapsedMs;
+	pausedElapsedMs = elapsedMs;
+	//Set the timers and ticks up for the current power policy.
+	if (isRunningFlag)
+	{
+		scheduleIntervalEnd();
+	}
+	updateRunTimeScreen();
+} //End resumeRunMode
+
 /**
  * In run mode, this will skip whatever time is remaining
  * in the current interval and move to the next
  */
 void skipToNextInterval()
 {
+	uint32_t now = timerWheelNow();
 
-	/*
-	 To avoid race conditions with the timer handler
-	 pause the timer before switching intervals.
-	 */
-	isRunningFlag = false;
-	//Reset the countup counter for elapsed time in the current interval
-	currSecCount = 0;
+	//Skipping always leaves the timer running.
+	if (!isRunningFlag)
+	{
+		runStartMs = now;
+		isRunningFlag = true;
+	}
+	//The new interval starts now
+	intervalStartMs = now;
 	//Move to the next interval
 	currRunInt++;
 	//Go back to the first interval if necessary
@@ -159,9 +623,9 @@ void skipToNextInterval()
 	{
 		currRunInt = 0;
 	}
-	updateRunTimeScreen();
-	//Restart the timer!
-	isRunningFlag = true;
+	scheduleIntervalEnd();
+	redrawRunScreen();
+	logSessionEvent(SESSION_SKIP_NEXT);
 } //End skipToNextInterval
 
 /**
@@ -170,9 +634,15 @@ void skipToNextInterval()
  **/
 void skipToPrevInterval()
 {
-	//Pause the timer
-	isRunningFlag = false;
-	currSecCount = 0;
+	uint32_t now = timerWheelNow();
+
+	//Skipping always leaves the timer running.
+	if (!isRunningFlag)
+	{
+		runStartMs = now;
+		isRunningFlag = true;
+	}
+	intervalStartMs = now;
 
 	//Figure out which interval to go to.
 	if (currRunInt == 0)
@@ -183,9 +653,9 @@ void skipToPrevInterval()
 	{
 		currRunInt--;
 	}
-	updateRunTimeScreen();
-	//Restart the time.
-	isRunningFlag = true;
+	scheduleIntervalEnd();
+	redrawRunScreen();
+	logSessionEvent(SESSION_SKIP_PREV);
 } //End skipToPrevInterval
 
 /**
@@ -193,85 +663,77 @@ void skipToPrevInterval()
  */
 void toggleRunning()
 {
+	uint32_t now = timerWheelNow();
+
 	isRunningFlag = !isRunningFlag;
+	if (!isRunningFlag)
+	{
+		//Remember where we were and stop the interval timers.
+		pausedElapsedMs = now - intervalStartMs;
+		totalRunMs += now - runStartMs;
+		timerWheelCancel(TIMER_PROGRAM);
+		timerWheelCancel(TIMER_GRANULARITY);
+		//Nothing changes on screen while paused.
+		updateTickService();
+		//Show the full time we paused at.
+		redrawRunScreen();
+		logSessionEvent(SESSION_PAUSE);
+	}
+	else
+	{
+		//Pick the interval back up where it was paused.
+		intervalStartMs = now - pausedElapsedMs;
+		runStartMs = now;
+		scheduleIntervalEnd();
+		//The low power display won't change for up to a minute.
+		redrawRunScreen();
+		logSessionEvent(SESSION_RESUME);
+	}
 } //End toggleRunning
 
 /**
- * Update the timers in run mode. Called every second
- * by a timer handler.
+ * Update the countdown in run mode. Called every second by the tick
+ * handler. The interval boundaries and the low power display's changes
+ * come from the timer wheel, not from here.
  */
 void tick()
 {
-	uint16_t *intervals = getIntervals();
-	uint8_t intervalCount = getIntervalCount();
 	//We don't do any thing if the timers aren't running
-	if (!isRunningFlag)
+	if (!isRunningFlag || isRenderingSuspended())
 	{
 		return;
 	}
-	//Increment the seconds elapsed in current interval counter
-	currSecCount++;
+	//Update the screen to show that a second elapsed. It is worked out for
+	//the second the tick is for, not when it arrived, so a late tick can't
+	//show the same second twice or skip one next to an interval boundary.
+	showRunTime(timerWheelSecond());
+} //End tick
 
-	//Check to see if we have gone over the time we set for this interval
-	if (currSecCount > intervals[currRunInt])
+/**
+ * The power policy changed. The minutes only display may have
+ * been turned on or off, so set the timers and ticks up again.
+ * Outside run mode there is nothing to do: activateRunMode() and
+ * resumeRunMode() pick the policy up when the run screen comes back.
+ */
+void updateRunPowerPolicy()
+{
+	if (getCurrState() != RUN_MODE)
 	{
-		//If so, we need to go to the next interval.
-		//Reset the seconds elapsed in current interval counter
-		currSecCount = 0;
-		//Go to the next interval
-		currRunInt++;
-		//This will vibrate the same number of interval we just finished
-		vibeCount = currRunInt;
-		//Start the vibrating
-		handle_timer_event();
-
-		//Make sure we don't need to go back to the first interval.
-		if (currRunInt >= intervalCount)
-		{
-			currRunInt = 0;
-		}
-		//Update the screen
-		updateRunTimeScreen();
-
-		//We don't want to do the rest of the stuff in the function.
 		return;
 	}
-	//Increment the elapsed time counter
-	totalRunCount++;
-
-	//Update the screen to show that a second elapsed.
-	updateRunTimeScreen();
-} //End tick
+	if (isRunningFlag)
+	{
+		scheduleIntervalEnd();
+	}
+	redrawRunScreen();
+}
 
 /**
  * Update the screen to show the change in the timers.
  */
 void updateRunTimeScreen()
 {
+	showRunTime(timerWheelNow());
+}
 
-	uint16_t *intervals = getIntervals();
-	uint8_t intervalCount = getIntervalCount();
-	char * setTimeTitleStr = getTimeTitleStr();
-	//Get the seconds remaining in this interval
-	formatTime(intervals[currRunInt] - currSecCount, timeStringText, false);
-	//Get the total time elapsed time string
-	formatTime(totalRunCount, runTimeStringText, true);
-	//Update the number of interval we're on.
-	if (currRunInt + 1 < 10)
-	{
-		setTimeTitleStr[9] = currRunInt + 1 + 48;
-		setTimeTitleStr[10] = 0;
-	}
-	else
-	{
-		setTimeTitleStr[9] = (currRunInt + 1) / 10 + 48;
-		setTimeTitleStr[10] = (currRunInt + 1) % 10 + 48;
-		setTimeTitleStr[11] = 0;
-	}
-
-	//Update the corresponding text layers
-	text_layer_set_text(runModeIntervalTextLayer, setTimeTitleStr);
-	text_layer_set_text(runModeIntRunTimeTextLayer, timeStringText);
-	text_layer_set_text(runModeTotalRunTimeTextLayer, runTimeStringText);
-} //End updateRunTimeScreen
 
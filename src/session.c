@@ -0,0 +1,375 @@
+/**
+ * File: session.c
+ * @author agent <agent@local>
+ *
+ * Keeps the run in persistent storage so it survives the app closing,
+ * crashing or the battery being pulled, and restores it on the next launch.
+ *
+ * The run is stored as a snapshot plus a write-ahead log. The snapshot
+ * holds the session itself (the interval count and times), where the run
+ * was up to, and the wall clock time it was taken. Starting a run writes a
+ * new snapshot. Every pause, resume, skip and interval boundary after that
+ * adds a small record to the log with its own wall clock time.
+ *
+ * Flash wears out, so records are collected in memory and written in
+ * batches, at most once every LOG_FLUSH_GAP_MS. When the log gets long it
+ * is compacted: the snapshot is moved up to the present and the log is
+ * emptied. On launch the log is replayed on top of the snapshot and the
+ * time since the last record is added on in one go. Only records newer
+ * than the snapshot are replayed, so a log left over from before a
+ * compaction is never applied twice.
+ *
+ */
+#include <pebble.h>
+#include "../includes/config.h"
+#include "../includes/types.h"
+#include "../includes/intervals.h"
+#include "../includes/runScreen.h"
+#include "../includes/session.h"
+#include "../includes/timerWheel.h"
+
+//Bump this whenever RunSnapshot or SessionRecord changes so old saves are ignored.
+#define SNAPSHOT_VERSION 1
+//The longest time closed we can count in ms (about 46 days).
+#define MAX_CLOSED_SECS 4000000
+//How many records fit in one persist key, after the count.
+#define LOG_MAX_RECORDS 31
+//Compact at the next write once the log has this many records.
+#define LOG_COMPACT_AT 24
+//The shortest time between writes. Each write is at most two keys,
+//so this keeps it to 8 flash writes a minute however busy the run is.
+#define LOG_FLUSH_GAP_MS 15000
+
+//Everything needed to pick a run back up.
+typedef struct
+{
+	uint8_t version;
+	uint8_t intervalCount;
+	uint8_t currRunInt;
+	uint8_t running;
+	//Wall clock time the snapshot was taken.
+	uint32_t stampSec;
+	uint16_t stampMs;
+	//How far into the interval, and the total run time, at that moment.
+	uint32_t elapsedMs;
+	uint32_t totalMs;
+	uint16_t intervals[MAX_INTERVALS];
+} __attribute__((__packed__)) RunSnapshot;
+
+//One log record: what happened, the interval the run was in after it, and when.
+typedef struct
+{
+	uint8_t event;
+	uint8_t interval;
+	uint16_t stampMs;
+	uint32_t stampSec;
+} __attribute__((__packed__)) SessionRecord;
+
+//The log as it is stored.
+typedef struct
+{
+	uint8_t count;
+	SessionRecord records[LOG_MAX_RECORDS];
+} __attribute__((__packed__)) SessionLog;
+
+static SessionLog sessionLog;
+//How many of the records are already in flash, and whether the snapshot
+//in flash is out of date.
+static uint8_t flushedCount = 0;
+static bool snapshotStale = false;
+//Only a run that was started or restored is logged.
+static bool sessionActive = false;
+//When the last write was, in timerWheelNow() time.
+static uint32_t lastFlushMs = 0;
+static bool flushedOnce = false;
+
+/**
+ * Write the run as it is right now as the snapshot.
+ */
+static void writeSnapshot()
+{
+	RunSnapshot snapshot;
+	time_t nowSec;
+	uint16_t nowMs;
+	uint16_t *intervals = getIntervals();
+	uint32_t elapsedMs, totalMs;
+	uint8_t i, interval;
+
+	getRunState(&interval, &elapsedMs, &totalMs);
+	snapshot.version = SNAPSHOT_VERSION;
+	snapshot.intervalCount = getIntervalCount();
+	snapshot.currRunInt = interval;
+	snapshot.running = isRunning();
+	snapshot.elapsedMs = elapsedMs;
+	snapshot.totalMs = totalMs;
+	for (i = 0; i < MAX_INTERVALS; i++)
+	{
+		snapshot.intervals[i] = intervals[i];
+	}
+	time_ms(&nowSec, &nowMs);
+	snapshot.stampSec = nowSec;
+	snapshot.stampMs = nowMs;
+
+	persist_write_data(PERSIST_SESSION_SNAPSHOT, &snapshot, sizeof(snapshot));
+} //End writeSnapshot
+
+/**
+ * Called by the timer wheel to write out the records collected since
+ * the last write. A long log is compacted first.
+ */
+static void flushSessionLog()
+{
+	if (sessionLog.count == flushedCount && !snapshotStale)
+	{
+		return;
+	}
+	if (sessionLog.count >= LOG_COMPACT_AT)
+	{
+		//Everything in the log is already in the live state.
+		sessionLog.count = 0;
+		snapshotStale = true;
+	}
+	if (snapshotStale)
+	{
+		writeSnapshot();
+		snapshotStale = false;
+	}
+	persist_write_data(PERSIST_SESSION_LOG, &sessionLog,
+			1 + sessionLog.count * sizeof(SessionRecord));
+	flushedCount = sessionLog.count;
+	lastFlushMs = timerWheelNow();
+	flushedOnce = true;
+} //End flushSessionLog
+
+/**
+ * Make sure a write is coming, no sooner than LOG_FLUSH_GAP_MS
+ * after the last one.
+ */
+static void scheduleFlush()
+{
+	uint32_t now = timerWheelNow();
+
+	if (timerWheelIsScheduled(TIMER_SESSION_LOG))
+	{
+		return;
+	}
+	if (flushedOnce && (int32_t) (lastFlushMs + LOG_FLUSH_GAP_MS - now) > 0)
+	{
+		timerWheelSchedule(TIMER_SESSION_LOG, lastFlushMs + LOG_FLUSH_GAP_MS,
+				flushSessionLog);
+	}
+	else
+	{
+		timerWheelSchedule(TIMER_SESSION_LOG, now, flushSessionLog);
+	}
+}
+
+/**
+ * Forget the saved run. Called when run mode is left for the set screens.
+ */
+void clearSession()
+{
+	sessionActive = false;
+	timerWheelCancel(TIMER_SESSION_LOG);
+	sessionLog.count = 0;
+	flushedCount = 0;
+	persist_delete(PERSIST_SESSION_SNAPSHOT);
+	persist_delete(PERSIST_SESSION_LOG);
+}
+
+/**
+ * Add something that happened to the run to the log. Call it after
+ * the run state has changed. It reaches flash with the next batch.
+ *
+ * @param event - what happened
+ */
+void logSessionEvent(SessionEvent event)
+{
+	time_t nowSec;
+	uint16_t nowMs;
+	uint32_t elapsedMs, totalMs;
+	uint8_t interval;
+	SessionRecord *record;
+
+	if (!sessionActive)
+	{
+		return;
+	}
+	if (sessionLog.count == LOG_MAX_RECORDS)
+	{
+		//No room until the next write. Compact in memory instead.
+		sessionLog.count = 0;
+		flushedCount = 0;
+		snapshotStale = true;
+	}
+	if (snapshotStale)
+	{
+		//The next write takes a new snapshot of the live state,
+		//which already includes this event.
+		scheduleFlush();
+		return;
+	}
+
+	record = &sessionLog.records[sessionLog.count++];
+	getRunState(&interval, &elapsedMs, &totalMs);
+	record->event = event;
+	record->interval = interval;
+	time_ms(&nowSec, &nowMs);
+	record->stampSec = nowSec;
+	record->stampMs = nowMs;
+	scheduleFlush();
+} //End logSessionEvent
+
+/**
+ * Load the saved run, if there is one, replay its log and go straight
+ * back into it. The run is compacted and saved again straight away so
+ * it is still there if the app goes down again.
+ *
+ * @return true if a run was restored
+ */
+bool restoreSession()
+{
+	RunSnapshot snapshot;
+	time_t nowSec;
+	uint16_t nowMs;
+	uint32_t closedSecs, closedMs = 0, gapMs;
+	uint32_t stampSec, stampMs, elapsedMs, totalMs;
+	uint16_t *intervals = getIntervals();
+	uint8_t i, interval;
+	bool running;
+	SessionRecord *record;
+
+	if (!persist_exists(PERSIST_SESSION_SNAPSHOT))
+	{
+		return false;
+	}
+	persist_read_data(PERSIST_SESSION_SNAPSHOT, &snapshot, sizeof(snapshot));
+	if (snapshot.version != SNAPSHOT_VERSION || snapshot.intervalCount < 1
+			|| snapshot.intervalCount > MAX_INTERVALS)
+	{
+		clearSession();
+		return false;
+	}
+
+	//Put the session's intervals back.
+	for (i = 0; i < snapshot.intervalCount; i++)
+	{
+		intervals[i] = snapshot.intervals[i];
+	}
+	setIntervalCount(snapshot.intervalCount);
+
+	//Start from the snapshot.
+	interval = snapshot.currRunInt;
+	elapsedMs = snapshot.elapsedMs;
+	totalMs = snapshot.totalMs;
+	running = snapshot.running;
+	stampSec = snapshot.stampSec;
+	stampMs = snapshot.stampMs;
+	if (interval >= snapshot.intervalCount)
+	{
+		interval = 0;
+		elapsedMs = 0;
+	}
+
+	//Replay the log on top of it.
+	sessionLog.count = 0;
+	if (persist_exists(PERSIST_SESSION_LOG))
+	{
+		persist_read_data(PERSIST_SESSION_LOG, &sessionLog, sizeof(sessionLog));
+		if (sessionLog.count > LOG_MAX_RECORDS)
+		{
+			sessionLog.count = 0;
+		}
+	}
+	for (i = 0; i < sessionLog.count; i++)
+	{
+		record = &sessionLog.records[i];
+		if (record->interval >= snapshot.intervalCount)
+		{
+			continue;
+		}
+		//The snapshot is written before the log, so a reset in between leaves
+		//the old log behind a newer snapshot. Its records are already in it.
+		if (record->stampSec < snapshot.stampSec
+				|| (record->stampSec == snapshot.stampSec
+						&& record->stampMs <= snapshot.stampMs))
+		{
+			continue;
+		}
+		//Run the clock up to the record. Ignore it if the clock went backwards.
+		gapMs = 0;
+		if (record->stampSec > stampSec
+				|| (record->stampSec == stampSec && record->stampMs > stampMs))
+		{
+			gapMs = (record->stampSec - stampSec) * 1000 + record->stampMs
+					- stampMs;
+		}
+		if (running)
+		{
+			advanceRunPosition(&interval, &elapsedMs, gapMs);
+			totalMs += gapMs;
+		}
+		stampSec = record->stampSec;
+		stampMs = record->stampMs;
+
+		switch (record->event)
+		{
+		case SESSION_PAUSE:
+			running = false;
+			break;
+		case SESSION_RESUME:
+			running = true;
+			break;
+		default:
+			//Skips and boundaries start an interval from the top, running.
+			interval = record->interval;
+			elapsedMs = 0;
+			running = true;
+			break;
+		}
+	}
+
+	//How long were we closed? Ignore it if the clock went backwards.
+	time_ms(&nowSec, &nowMs);
+	if ((uint32_t) nowSec > stampSec)
+	{
+		closedSecs = (uint32_t) nowSec - stampSec;
+		if (closedSecs > MAX_CLOSED_SECS)
+		{
+			closedSecs = MAX_CLOSED_SECS;
+		}
+		closedMs = closedSecs * 1000 + nowMs - stampMs;
+	}
+
+	resumeRunMode(interval, elapsedMs, totalMs, running, closedMs);
+	sessionActive = true;
+	saveSession();
+	return true;
+} //End restoreSession
+
+/**
+ * Compact the run into the snapshot and write it now. Called when the
+ * app closes in run mode.
+ */
+void saveSession()
+{
+	timerWheelCancel(TIMER_SESSION_LOG);
+	sessionLog.count = 0;
+	flushedCount = 0;
+	snapshotStale = false;
+	writeSnapshot();
+	persist_delete(PERSIST_SESSION_LOG);
+}
+
+/**
+ * A new run was started from the set screens. Its snapshot
+ * (with the interval times) is the start of the log.
+ */
+void startSession()
+{
+	sessionActive = true;
+	sessionLog.count = 0;
+	flushedCount = 0;
+	snapshotStale = true;
+	scheduleFlush();
+}
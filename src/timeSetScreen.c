@@ -13,27 +13,107 @@
 #include <pebble.h>
 #include <pebble_fonts.h>
 #include "../includes/types.h"
+#include "../includes/hud.h"
 #include "../includes/intervals.h"
+#include "../includes/layout.h"
+#include "../includes/perfStats.h"
+#include "../includes/powerPolicy.h"
+#include "../includes/render.h"
 #include "../includes/timeSetScreen.h"
+#include "../includes/timerWheel.h"
 
 //Reference to this layer pointer from intervals.c
 extern Layer *setTimeLayer;
 
-//Visual elements for this layer
-TextLayer *setTimeModeText, *setTimeTitle, *colonString, *minStr, *secStr;
-
 //A flag to indicate what unit of time we're adjusting.
 SettingsUnit setting_unit = SETTING_MINUTE;
 
-//This flag is used to know what color to set the selected unit so it looks like
+//This flag is used to know whether to draw the selected unit so it looks like
 //it is flashing.
 bool unitShown = true;
 
+/*
+ How a held up/down button speeds up. Once the button has been held for
+ heldMs, each repeat moves the unit by step every repeatMs.
+ */
+typedef struct
+{
+	uint16_t heldMs;
+	uint8_t step;
+	uint16_t repeatMs;
+} HoldStage;
+
+static const HoldStage holdStages[] =
+{
+{ 0, 1, 200 },
+{ 2000, 5, 150 },
+{ 4000, 15, 100 } };
+
+//How long a button has to be held before it starts repeating.
+#define HOLD_FIRST_REPEAT_MS 400
+
+//Which way the held button moves the time, and when it was pressed.
+int8_t holdDirection = 0;
+uint32_t holdStartMs = 0;
+
 //Text strings used through this screen.
 char minStrTxt[3] = "00";
 char secStrTxt[3] = "00";
 char fullText[9];
 
+/*
+ The text on this screen. The interval title is filled in when it is built.
+ The time is drawn in three parts so the units can flash on their own.
+ They all come from the digit atlas.
+ */
+enum
+{
+	SET_MODE_TEXT, SET_TITLE, SET_COLON, SET_MINUTES, SET_SECONDS, SET_TEXT_TOTAL
+};
+static const TextLayoutDesc setLayoutDesc[SET_TEXT_TOTAL] =
+{
+//Current layer mode text
+{ LAYOUT_FRAME(0, 15, SCREEN_WIDTH, 40), FONT_KEY_GOTHIC_24_BOLD,
+		GTextAlignmentCenter, "Set Mode" },
+//Setting interval counter
+{ LAYOUT_FRAME(0, 40, SCREEN_WIDTH, 40), FONT_KEY_GOTHIC_24_BOLD,
+		GTextAlignmentCenter, NULL },
+//The colon, in the middle of the screen
+{ LAYOUT_FRAME(SCREEN_WIDTH / 2 - 5, 80, 10, 50), NULL,
+		GTextAlignmentCenter, ":" },
+//Minutes, up against the colon
+{ LAYOUT_FRAME(0, 80, SCREEN_WIDTH / 2 - 5, 50), NULL,
+		GTextAlignmentRight, minStrTxt },
+//Seconds
+{ LAYOUT_FRAME(SCREEN_WIDTH / 2 + 5, 80, SCREEN_WIDTH / 2 - 5, 50), NULL,
+		GTextAlignmentLeft, secStrTxt } };
+static TextLayout setLayout[SET_TEXT_TOTAL];
+
+/**
+ * Draw the whole screen. This is the update proc for setTimeLayer.
+ * The text is worked out here from the current time, so however many
+ * changes were made since the last frame it is only done once.
+ * The unit being set is left out every other flash.
+ */
+static void drawTimeSetScreen(Layer *layer, GContext *ctx)
+{
+	uint8_t hidden = (setting_unit == SETTING_MINUTE) ? SET_MINUTES : SET_SECONDS;
+	uint8_t i;
+
+	updateSetTimeScreen();
+	perfStatsRedraw(layer);
+	perfStatsEndFrame("drawTimeSetScreen");
+
+	graphics_context_set_text_color(ctx, GColorBlack);
+	for (i = 0; i < SET_TEXT_TOTAL; i++)
+	{
+		if (unitShown || i != hidden)
+		{
+			drawLayout(ctx, &setLayout[i]);
+		}
+	}
+}
+
 /**
  * Change the amount of seconds the currIntervalSetIdx
  * interval timer will be set for.
@@ -65,74 +145,113 @@ void adjustIntervalSetTime(int8_t change)
 	{
 		intervals[currIntervalSetIdx] = newTime;
 		//Update the screen.
-		updateSetTimeScreen();
+		markScreenDirty(DIRTY_SET_TIME);
 	}
 	else if (change < 0)
 	{
 		//The user tried to zero out the timer.
 		intervals[currIntervalSetIdx] = 0;
 		//Update the screen
-		updateSetTimeScreen();
+		markScreenDirty(DIRTY_SET_TIME);
+	}
+	else if (intervals[currIntervalSetIdx] != 3599)
+	{
+		//A big step went over the limit, stop at the limit.
+		intervals[currIntervalSetIdx] = 3599;
+		markScreenDirty(DIRTY_SET_TIME);
 	}
 } //End adjustIntervalSetTime
 
 /**
  * Change the unit we're currently setting.
  * Also make sure whatever we had been previously
- * setting gets set to black so it doesn't disappear.
+ * setting is shown so it doesn't disappear.
  */
 void changeUnit()
 {
-	//Make sure we don't accidentally leave one white and unreadable.
-	text_layer_set_text_color(minStr, GColorBlack);
-	text_layer_set_text_color(secStr, GColorBlack);
+	//Make sure we don't accidentally leave one hidden.
+	unitShown = true;
+	perfStatsShown(&setLayout[SET_MINUTES], true);
+	perfStatsShown(&setLayout[SET_SECONDS], true);
+	layer_mark_dirty(setTimeLayer);
 	//Change the unit
 	setting_unit = !setting_unit;
 } //End changeUnit
 
-/**
- * Clean up this layer
- */
-void deinitTimeSetScreen()
-{
-	text_layer_destroy(setTimeModeText);
-	text_layer_destroy(setTimeTitle);
-	text_layer_destroy(colonString);
-	text_layer_destroy(minStr);
-	text_layer_destroy(secStr);
-}
-
 /**
  * Make the unit flash! This function is
- * called from a timer handler.
+ * called from the timer wheel while in TIME_SET.
  */
 void flashUnit()
 {
-	GColor newColor;
-	//Determine the color to set
-	if (unitShown)
+	//Economy mode doesn't flash.
+	if (!powerPolicy()->flashUnits)
 	{
-		newColor = GColorWhite;
+		startUnitFlash();
+		return;
 	}
-	else
+	//Nobody can see it. Flashing starts again when the app is back in focus.
+	if (isRenderingSuspended())
 	{
-		newColor = GColorBlack;
+		return;
 	}
+
 	unitShown = !unitShown;
 
-	//Determine the unit whose color should change.
+	//Determine the unit that is flashing.
 	if (setting_unit == SETTING_MINUTE)
 	{
-		text_layer_set_text_color(minStr, newColor);
+		perfStatsShown(&setLayout[SET_MINUTES], unitShown);
 	}
 	else
 	{
-		text_layer_set_text_color(secStr, newColor);
+		perfStatsShown(&setLayout[SET_SECONDS], unitShown);
 	}
+	layer_mark_dirty(setTimeLayer);
 	//Reload the timer
-	app_timer_register(150, (AppTimerCallback) handle_timer_event, NULL);
+	timerWheelScheduleIn(TIMER_FLASH, 150, flashUnit);
+	hudCount(HUD_FLASH_TIMER);
 }
 
+/**
+ * Called by the timer wheel while an up/down button is held.
+ * The longer it is held the bigger and quicker the steps get.
+ * Big steps land on a multiple of the step size.
+ */
+void holdRepeat()
+{
+	uint16_t *intervals = getIntervals();
+	uint16_t time = intervals[getCurrIntervalSetIdx()];
+	uint32_t held = timerWheelNow() - holdStartMs;
+	uint8_t stage = sizeof(holdStages) / sizeof(holdStages[0]) - 1;
+	uint8_t unitValue, offset;
+
+	//The button can't still be held if we left the screen.
+	if (getCurrState() != TIME_SET)
+	{
+		return;
+	}
+	while (stage > 0 && held < holdStages[stage].heldMs)
+	{
+		stage--;
+	}
+
+	//Step to the next multiple of the step size in the held direction.
+	unitValue = (setting_unit == SETTING_SECOND) ? time % 60 : time / 60;
+	offset = unitValue % holdStages[stage].step;
+	if (holdDirection > 0)
+	{
+		adjustIntervalSetTime(holdStages[stage].step - offset);
+	}
+	else
+	{
+		adjustIntervalSetTime(-(offset ? offset : holdStages[stage].step));
+	}
+
+	timerWheelScheduleIn(TIMER_HOLD_REPEAT, holdStages[stage].repeatMs,
+			holdRepeat);
+} //End holdRepeat
+
 /**
  * Build this screen.
  */
@@ -140,46 +259,60 @@ void initTimeSetScreen()
 {
 	layer_set_hidden(setTimeLayer, true);
 
-	//Current layer mode text
-	setTimeModeText = text_layer_create(GRect(0, 15, 144, 40));
-	text_layer_set_text(setTimeModeText, "Set Mode");
-	text_layer_set_font(setTimeModeText,
-			fonts_get_system_font(FONT_KEY_GOTHIC_24_BOLD));
-	text_layer_set_text_alignment(setTimeModeText, GTextAlignmentCenter);
-	layer_add_child(setTimeLayer, text_layer_get_layer(setTimeModeText));
-
-	//Setting interval counter
-	setTimeTitle = text_layer_create(GRect(0, 40, 144, 40));
-	text_layer_set_text(setTimeTitle, "Interval 00");
-	text_layer_set_font(setTimeTitle,
-			fonts_get_system_font(FONT_KEY_GOTHIC_24_BOLD));
-	text_layer_set_text_alignment(setTimeTitle, GTextAlignmentCenter);
-	layer_add_child(setTimeLayer, text_layer_get_layer(setTimeTitle));
-
-	//Create the three layers for displaying time.
-	//This one is for the colon
-	colonString = text_layer_create(GRect(0, 80, 144, 50));
-	text_layer_set_text(colonString, ":");
-	text_layer_set_font(colonString,
-			fonts_get_system_font(FONT_KEY_BITHAM_42_BOLD));
-	text_layer_set_text_alignment(colonString, GTextAlignmentCenter);
-	layer_add_child(setTimeLayer, text_layer_get_layer(colonString));
-
-	//Minutes
-	minStr = text_layer_create(GRect(0, 80, 70, 50));
-	text_layer_set_font(minStr, fonts_get_system_font(FONT_KEY_BITHAM_42_BOLD));
-	text_layer_set_text_alignment(minStr, GTextAlignmentRight);
-	layer_add_child(setTimeLayer, text_layer_get_layer(minStr));
-
-	//Seconds
-	secStr = text_layer_create(GRect(74, 80, 70, 50));
-	text_layer_set_font(secStr, fonts_get_system_font(FONT_KEY_BITHAM_42_BOLD));
-	text_layer_set_text_alignment(secStr, GTextAlignmentLeft);
-	layer_add_child(setTimeLayer, text_layer_get_layer(secStr));
+	buildLayout(setLayoutDesc, setLayout, SET_TEXT_TOTAL);
+	setLayout[SET_TITLE].text = getTimeTitleStr();
+	layer_set_update_proc(setTimeLayer, drawTimeSetScreen);
+}
+
+/**
+ * An up or down button was pressed. Move by one and start repeating
+ * if it is held.
+ *
+ * @param direction - 1 for up, -1 for down
+ */
+void startTimeSetHold(int8_t direction)
+{
+	holdDirection = direction;
+	holdStartMs = timerWheelNow();
+	adjustIntervalSetTime(direction);
+	timerWheelScheduleIn(TIMER_HOLD_REPEAT, HOLD_FIRST_REPEAT_MS, holdRepeat);
+}
+
+/**
+ * Start the unit being set flashing, if the power policy allows it.
+ * If it doesn't, make sure the unit is shown and leave it still.
+ */
+void startUnitFlash()
+{
+	if (isRenderingSuspended())
+	{
+		timerWheelCancel(TIMER_FLASH);
+		return;
+	}
+	if (powerPolicy()->flashUnits)
+	{
+		timerWheelScheduleIn(TIMER_FLASH, 150, flashUnit);
+		return;
+	}
+	timerWheelCancel(TIMER_FLASH);
+	if (!unitShown)
+	{
+		unitShown = true;
+		layer_mark_dirty(setTimeLayer);
+	}
+}
+
+/**
+ * The held button was let go.
+ */
+void stopTimeSetHold()
+{
+	timerWheelCancel(TIMER_HOLD_REPEAT);
 }
 
 /**
- * Update the screen during time set mode. This is a weird one.
+ * Work out the text for the time set screen from the interval being set.
+ * Called by drawTimeSetScreen(); everything else just marks the screen dirty.
  */
 void updateSetTimeScreen()
 {
@@ -193,7 +326,7 @@ void updateSetTimeScreen()
 	formatTime(intervals[currIntervalSetIdx], fullText, false);
 
 	/**
-	 Because the units flash, they are actually two separate text layers.
+	 Because the units flash, they are drawn as two separate pieces of text.
 	 So the minutes and seconds are extracted from the string filled in the formatTime function
 	 and placed into other variables so they can be updated separately.
 	 **/
@@ -219,7 +352,7 @@ void updateSetTimeScreen()
 		setTimeTitleStr[11] = 0;
 	}
 
-	text_layer_set_text(minStr, minStrTxt);
-	text_layer_set_text(secStr, secStrTxt);
-	text_layer_set_text(setTimeTitle, setTimeTitleStr);
+	perfStatsText(&setLayout[SET_MINUTES], minStrTxt);
+	perfStatsText(&setLayout[SET_SECONDS], secStrTxt);
+	perfStatsText(&setLayout[SET_TITLE], setTimeTitleStr);
 } //End updateSetTimeScreen
@@ -0,0 +1,311 @@
+/**
+ * File: timerWheel.c
+ * @author agent <agent@local>
+ *
+ * Every timer in the app (interval boundaries, vibration pulses, unit
+ * flashing) has a slot here with an absolute deadline. The slots are kept
+ * in a small min-heap ordered by deadline and a single AppTimer is armed for
+ * whichever one is due first. However many slots are waiting, the watch
+ * only wakes up when something is actually due. This is the groundwork for
+ * running several interval programs at once; the app itself still runs one.
+ *
+ * Deadlines are in milliseconds since the app started. They wrap after
+ * about 49 days, so they are always compared by their difference.
+ *
+ */
+#include <pebble.h>
+#include "../includes/types.h"
+#include "../includes/hud.h"
+#include "../includes/timerWheel.h"
+#include "../includes/trace.h"
+
+//A slot's deadline, what to call, and where it is in the heap (-1 if idle).
+//Due is set between being taken off the heap and its handler being called.
+typedef struct
+{
+	uint32_t deadline;
+	TimerWheelHandler handler;
+	int8_t heapPos;
+	bool due;
+} TimerEntry;
+
+static TimerEntry entries[TIMER_SLOT_COUNT];
+//Slot numbers ordered so heap[0] is due first.
+static uint8_t heap[TIMER_SLOT_COUNT];
+static uint8_t heapSize = 0;
+
+//The one AppTimer and the deadline it was armed for.
+static AppTimer *armedTimer = NULL;
+static uint32_t armedDeadline;
+//Set while handlers are being called so they don't each re-arm.
+static bool firing = false;
+
+//When the app started, the zero point for deadlines.
+static time_t startSec;
+static uint16_t startMs;
+
+/**
+ * True if slot a is due before slot b.
+ */
+static bool dueBefore(uint8_t a, uint8_t b)
+{
+	return (int32_t) (entries[a].deadline - entries[b].deadline) < 0;
+}
+
+/**
+ * Swap two heap positions and keep the back references right.
+ */
+static void heapSwap(uint8_t i, uint8_t j)
+{
+	uint8_t tmp = heap[i];
+	heap[i] = heap[j];
+	heap[j] = tmp;
+	entries[heap[i]].heapPos = i;
+	entries[heap[j]].heapPos = j;
+}
+
+/**
+ * Move the slot at pos towards the top until its parent is due first.
+ */
+static void heapUp(uint8_t pos)
+{
+	while (pos > 0 && dueBefore(heap[pos], heap[(pos - 1) / 2]))
+	{
+		heapSwap(pos, (pos - 1) / 2);
+		pos = (pos - 1) / 2;
+	}
+}
+
+/**
+ * Move the slot at pos towards the bottom until both children are due after it.
+ */
+static void heapDown(uint8_t pos)
+{
+	uint8_t child;
+	while ((child = pos * 2 + 1) < heapSize)
+	{
+		if (child + 1 < heapSize && dueBefore(heap[child + 1], heap[child]))
+		{
+			child++;
+		}
+		if (!dueBefore(heap[child], heap[pos]))
+		{
+			break;
+		}
+		heapSwap(pos, child);
+		pos = child;
+	}
+}
+
+/**
+ * Take a slot out of the heap.
+ */
+static void heapRemove(uint8_t slot)
+{
+	uint8_t pos = entries[slot].heapPos;
+	uint8_t moved;
+
+	entries[slot].heapPos = -1;
+	heapSize--;
+	if (pos == heapSize)
+	{
+		return;
+	}
+	//Fill the hole with the last slot and put that one where it belongs.
+	moved = heap[heapSize];
+	heap[pos] = moved;
+	entries[moved].heapPos = pos;
+	heapUp(pos);
+	heapDown(entries[moved].heapPos);
+}
+
+static void timerWheelFire(void *data);
+
+/**
+ * Make sure the AppTimer is armed for the nearest deadline, and only that.
+ */
+static void rearm()
+{
+	uint32_t deadline, now;
+	int32_t delay;
+
+	if (firing)
+	{
+		return;
+	}
+	if (heapSize == 0)
+	{
+		if (armedTimer != NULL)
+		{
+			app_timer_cancel(armedTimer);
+			armedTimer = NULL;
+		}
+		return;
+	}
+
+	deadline = entries[heap[0]].deadline;
+	if (armedTimer != NULL && armedDeadline == deadline)
+	{
+		return;
+	}
+	now = timerWheelNow();
+	delay = (int32_t) (deadline - now);
+	if (delay < 0)
+	{
+		delay = 0;
+	}
+	armedDeadline = deadline;
+	if (armedTimer == NULL || !app_timer_reschedule(armedTimer, delay))
+	{
+		armedTimer = app_timer_register(delay,
+				(AppTimerCallback) timerWheelFire, NULL);
+	}
+} //End rearm
+
+/**
+ * The AppTimer callback. Runs every slot that is due.
+ * Slots rescheduled by their handlers wait for the next wakeup.
+ */
+static void timerWheelFire(void *data)
+{
+	uint8_t due[TIMER_SLOT_COUNT];
+	uint8_t dueCount = 0, i;
+	uint32_t now = timerWheelNow();
+
+	TRACE_EVENT(TRACE_TIMER);
+	hudCount(HUD_WAKEUP);
+	armedTimer = NULL;
+
+	//Take out everything that is due first, in deadline order.
+	while (heapSize > 0 && (int32_t) (entries[heap[0]].deadline - now) <= 0)
+	{
+		due[dueCount++] = heap[0];
+		entries[heap[0]].due = true;
+		heapRemove(heap[0]);
+	}
+
+	firing = true;
+	for (i = 0; i < dueCount; i++)
+	{
+		//An earlier handler may have cancelled or moved this one.
+		if (entries[due[i]].due)
+		{
+			entries[due[i]].due = false;
+			entries[due[i]].handler();
+		}
+	}
+	firing = false;
+
+	rearm();
+} //End timerWheelFire
+
+/**
+ * Stop a slot from firing. Does nothing if it isn't scheduled.
+ */
+void timerWheelCancel(TimerSlot slot)
+{
+	entries[slot].due = false;
+	if (entries[slot].heapPos < 0)
+	{
+		return;
+	}
+	heapRemove(slot);
+	rearm();
+}
+
+/**
+ * Clean up on app close.
+ */
+void timerWheelDeinit()
+{
+	if (armedTimer != NULL)
+	{
+		app_timer_cancel(armedTimer);
+		armedTimer = NULL;
+	}
+	heapSize = 0;
+}
+
+/**
+ * Set the zero point for deadlines and clear every slot.
+ */
+void timerWheelInit()
+{
+	uint8_t i;
+
+	time_ms(&startSec, &startMs);
+	for (i = 0; i < TIMER_SLOT_COUNT; i++)
+	{
+		entries[i].heapPos = -1;
+		entries[i].due = false;
+	}
+	heapSize = 0;
+}
+
+/**
+ * Returns true if the slot is waiting to fire.
+ */
+bool timerWheelIsScheduled(TimerSlot slot)
+{
+	return entries[slot].heapPos >= 0;
+}
+
+/**
+ * The current time in milliseconds since the app started.
+ */
+uint32_t timerWheelNow()
+{
+	time_t sec;
+	uint16_t ms;
+
+	time_ms(&sec, &ms);
+	return (sec - startSec) * 1000 + ms - startMs;
+}
+
+/**
+ * Schedule a slot to fire at an absolute deadline. If the slot
+ * was already scheduled, it is moved to the new deadline.
+ *
+ * @param slot - the slot to schedule
+ * @param deadline - when to fire, in timerWheelNow() time
+ * @param handler - the function to call
+ */
+void timerWheelSchedule(TimerSlot slot, uint32_t deadline,
+		TimerWheelHandler handler)
+{
+	entries[slot].deadline = deadline;
+	entries[slot].handler = handler;
+	entries[slot].due = false;
+
+	if (entries[slot].heapPos < 0)
+	{
+		entries[slot].heapPos = heapSize;
+		heap[heapSize++] = slot;
+	}
+	heapUp(entries[slot].heapPos);
+	heapDown(entries[slot].heapPos);
+	rearm();
+} //End timerWheelSchedule
+
+/**
+ * Schedule a slot to fire after a delay in milliseconds.
+ */
+void timerWheelScheduleIn(TimerSlot slot, uint32_t delay,
+		TimerWheelHandler handler)
+{
+	timerWheelSchedule(slot, timerWheelNow() + delay, handler);
+}
+
+/**
+ * The time the current wall clock second started, in timerWheelNow()
+ * time. The tick service ticks on these, so this is the time a tick is
+ * for however late it is handled.
+ */
+uint32_t timerWheelSecond()
+{
+	time_t sec;
+	uint16_t ms;
+
+	time_ms(&sec, &ms);
+	return (sec - startSec) * 1000 - startMs;
+}
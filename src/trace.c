@@ -0,0 +1,214 @@
+/**
+ * File: trace.c
+ * @author agent <agent@local>
+ *
+ * Event traces for debug builds.
+ *
+ * While recording, every button handler, tick and timer callback adds a
+ * four byte record to a buffer: one byte for the event and three bytes for
+ * the milliseconds since the previous record. The buffer is written to
+ * persistent storage when the app closes.
+ *
+ * While replaying, the saved trace is fed back through the same handlers
+ * with the same spacing. The real buttons and tick service are not hooked
+ * up so nothing else gets mixed in. Timer callbacks are not replayed, the
+ * app registers those itself as it goes. They are kept in the trace so
+ * both runs can be compared.
+ *
+ */
+#include <pebble.h>
+#include "../includes/types.h"
+#include "../includes/intervals.h"
+#include "../includes/trace.h"
+
+#ifdef TRACE_ENABLED
+
+//Records per persist key. How many keys the trace may use is in config.h.
+#define TRACE_RECORDS_PER_KEY (PERSIST_DATA_MAX_LENGTH / 4)
+#define TRACE_MAX_RECORDS (TRACE_RECORDS_PER_KEY * TRACE_KEY_COUNT)
+//The longest gap three bytes can hold (about 4.6 hours)
+#define TRACE_MAX_DELTA 0xFFFFFF
+
+//The records. Byte 0 is the event, bytes 1-3 the delta in ms.
+static uint8_t traceBuffer[TRACE_MAX_RECORDS][4];
+static uint16_t traceCount = 0;
+//Where replay is up to.
+static uint16_t replayIdx = 0;
+static bool replaying = false;
+//When the last record was taken.
+static time_t lastSec;
+static uint16_t lastMs;
+
+/**
+ * Milliseconds since the last record. Also moves the last record time to now.
+ */
+static uint32_t takeDelta()
+{
+	time_t nowSec;
+	uint16_t nowMs;
+	uint32_t delta;
+
+	time_ms(&nowSec, &nowMs);
+	delta = (nowSec - lastSec) * 1000 + nowMs - lastMs;
+	lastSec = nowSec;
+	lastMs = nowMs;
+
+	if (delta > TRACE_MAX_DELTA)
+	{
+		delta = TRACE_MAX_DELTA;
+	}
+	return delta;
+}
+
+/**
+ * The gap in ms before a record.
+ */
+static uint32_t recordDelta(uint16_t idx)
+{
+	return traceBuffer[idx][1] | (traceBuffer[idx][2] << 8)
+			| ((uint32_t) traceBuffer[idx][3] << 16);
+}
+
+/**
+ * Replays one record and schedules the next one.
+ */
+static void replayNext(void *data)
+{
+	TraceEvent event = traceBuffer[replayIdx][0];
+
+	replayIdx++;
+
+	switch (event)
+	{
+	case TRACE_BUTTON_UP:
+		button_pressed_up(NULL);
+		break;
+	case TRACE_BUTTON_DOWN:
+		button_pressed_down(NULL);
+		break;
+	case TRACE_SELECT:
+		select_pressed(NULL);
+		break;
+	case TRACE_SELECT_DOUBLE:
+		select_double_press(NULL);
+		break;
+	case TRACE_SELECT_LONG:
+		select_long_press(NULL);
+		break;
+	case TRACE_HOLD_UP:
+		button_held_up(NULL);
+		break;
+	case TRACE_HOLD_DOWN:
+		button_held_down(NULL);
+		break;
+	case TRACE_RELEASE:
+		button_released(NULL);
+		break;
+	case TRACE_TICK:
+		handle_second_tick(NULL, SECOND_UNIT | MINUTE_UNIT);
+		break;
+	default:
+		//Timer events come from the app itself.
+		break;
+	}
+
+	if (replayIdx < traceCount)
+	{
+		app_timer_register(recordDelta(replayIdx),
+				(AppTimerCallback) replayNext, NULL);
+	}
+	else
+	{
+		APP_LOG(APP_LOG_LEVEL_DEBUG, "trace: replayed %d events", traceCount);
+	}
+} //End replayNext
+
+/**
+ * Save the recorded trace. Called when the app closes.
+ */
+void traceDeinit()
+{
+	uint8_t key;
+	uint16_t start;
+
+	if (replaying)
+	{
+		return;
+	}
+	persist_write_int(PERSIST_TRACE_COUNT, traceCount);
+	for (key = 0; key < TRACE_KEY_COUNT; key++)
+	{
+		start = key * TRACE_RECORDS_PER_KEY;
+		if (start >= traceCount)
+		{
+			break;
+		}
+		persist_write_data(PERSIST_TRACE_DATA + key, traceBuffer[start],
+				PERSIST_DATA_MAX_LENGTH);
+	}
+	APP_LOG(APP_LOG_LEVEL_DEBUG, "trace: saved %d events", traceCount);
+} //End traceDeinit
+
+/**
+ * Start recording, or load the saved trace and start replaying it.
+ */
+void traceInit()
+{
+	time_ms(&lastSec, &lastMs);
+#ifdef INTERVALS_TRACE_REPLAY
+	uint8_t key;
+
+	if (persist_exists(PERSIST_TRACE_COUNT))
+	{
+		traceCount = persist_read_int(PERSIST_TRACE_COUNT);
+		if (traceCount > TRACE_MAX_RECORDS)
+		{
+			traceCount = TRACE_MAX_RECORDS;
+		}
+		for (key = 0; key < TRACE_KEY_COUNT; key++)
+		{
+			persist_read_data(PERSIST_TRACE_DATA + key,
+					traceBuffer[key * TRACE_RECORDS_PER_KEY],
+					PERSIST_DATA_MAX_LENGTH);
+		}
+		replaying = true;
+		replayIdx = 0;
+		APP_LOG(APP_LOG_LEVEL_DEBUG, "trace: replaying %d events", traceCount);
+		if (traceCount > 0)
+		{
+			app_timer_register(recordDelta(0), (AppTimerCallback) replayNext,
+					NULL);
+		}
+	}
+#endif
+} //End traceInit
+
+/**
+ * Returns true if the events are coming from a saved trace.
+ */
+bool traceIsReplaying()
+{
+	return replaying;
+}
+
+/**
+ * Add an event to the trace. Nothing is recorded while replaying
+ * or once the buffer is full.
+ */
+void traceRecord(TraceEvent event)
+{
+	uint32_t delta;
+
+	if (replaying || traceCount == TRACE_MAX_RECORDS)
+	{
+		return;
+	}
+	delta = takeDelta();
+	traceBuffer[traceCount][0] = event;
+	traceBuffer[traceCount][1] = delta & 0xFF;
+	traceBuffer[traceCount][2] = (delta >> 8) & 0xFF;
+	traceBuffer[traceCount][3] = (delta >> 16) & 0xFF;
+	traceCount++;
+} //End traceRecord
+
+#endif